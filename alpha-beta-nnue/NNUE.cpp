@@ -1,63 +1,127 @@
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
 #include "NNUE.hpp"
 
-using namespace torch::indexing;
+namespace {
 
-NNUE::evaluator::evaluator(const std::string path) {
-    torch::load(l0_weights, path + "input_layer.weight.pt");
-    torch::load(l0_biases, path + "input_layer.bias.pt");
-    torch::load(l1_weights, path + "fc1.weight.pt");
-    torch::load(l1_biases, path + "fc1.bias.pt");
-    torch::load(l2_weights, path + "fc2.weight.pt");
-    torch::load(l2_biases, path + "fc2.bias.pt");
-    torch::load(l3_weights, path + "fc3.weight.pt");
-    torch::load(l3_biases, path + "fc3.bias.pt");
+// Parameter tensor as one contiguous array of floats.
+std::vector<float> load_values(const std::string& path, torch::Tensor& tensor) {
+    torch::load(tensor, path);
+    tensor = tensor.to(torch::kFloat).contiguous();
+
+    return std::vector<float>(tensor.data_ptr<float>(), tensor.data_ptr<float>() + tensor.numel());
+}
+
+void relu(float* values, int count) {
+    for(int i = 0; i < count; i++) {
+        values[i] = std::max(values[i], 0.0f);
+    }
+}
+
+}
+
+void NNUE::layer::load(const std::string& weights_path, const std::string& biases_path) {
+    torch::Tensor tensor;
+    weights = load_values(weights_path, tensor);
+    outputs = static_cast<int>(tensor.size(0));
+    inputs = static_cast<int>(tensor.size(1));
+    biases = load_values(biases_path, tensor);
+
+    if(outputs > max_layer_size || static_cast<int>(biases.size()) != outputs) {
+        throw std::runtime_error("unexpected layer size in " + weights_path);
+    }
 }
 
-float NNUE::evaluator::forward(torch::Tensor accumulator_white, torch::Tensor accumulator_black, chess::side turn) {
+void NNUE::layer::forward(const float* input, float* output) const {
+    for(int row = 0; row < outputs; row++) {
+        const float* row_weights = weights.data() + static_cast<std::size_t>(row) * inputs;
+        float sum = biases[row];
 
-    torch::Tensor x;
+        for(int column = 0; column < inputs; column++) {
+            sum += row_weights[column] * input[column];
+        }
 
-    if(turn == chess::side_black) {
-		x = torch::cat({accumulator_black.unsqueeze(1), accumulator_white.unsqueeze(1)}, 0);
-	}
-	else {
-		x = torch::cat({accumulator_white.unsqueeze(1), accumulator_black.unsqueeze(1)}, 0);
-	}
+        output[row] = sum;
+    }
+}
+
+NNUE::evaluator::evaluator(const std::string path) {
+    // The input layer is M x features, a transposed copy keeps the weights of one feature together
+    torch::Tensor weights;
+    torch::load(weights, path + "input_layer.weight.pt");
+    weights = weights.to(torch::kFloat).t().contiguous();
 
-    auto z0 = torch::relu(x);
-    auto f1 = torch::matmul(l1_weights, z0).squeeze() + l1_biases;
+    if(weights.size(0) != features || weights.size(1) != M) {
+        throw std::runtime_error("unexpected input layer size in " + path);
+    }
 
-    auto z1 = torch::relu(f1);
+    l0_weights.assign(weights.data_ptr<float>(), weights.data_ptr<float>() + weights.numel());
 
-    auto f2 = torch::matmul(l2_weights, z1).squeeze() + l2_biases;
-    auto z2 = torch::relu(f2);
+    torch::Tensor biases;
+    std::vector<float> bias_values = load_values(path + "input_layer.bias.pt", biases);
+    std::copy_n(bias_values.begin(), M, l0_biases.begin());
 
-    auto output = torch::matmul(l3_weights, z2).squeeze() + l3_biases;
+    l1.load(path + "fc1.weight.pt", path + "fc1.bias.pt");
+    l2.load(path + "fc2.weight.pt", path + "fc2.bias.pt");
+    l3.load(path + "fc3.weight.pt", path + "fc3.bias.pt");
 
-    return output[0].item<float>();
+    if(l1.inputs != 2 * M || l2.inputs != l1.outputs || l3.inputs != l2.outputs || l3.outputs < 1) {
+        throw std::runtime_error("layer sizes of " + path + " do not fit together");
+    }
 }
 
-NNUE::accumulator::accumulator(const accumulator& other) {
+float NNUE::evaluator::forward(const std::array<float, M>& accumulator_white, const std::array<float, M>& accumulator_black, chess::side turn) const {
+
+    // The accumulator of the side to move comes first
+    const std::array<float, M>& own = turn == chess::side_black ? accumulator_black : accumulator_white;
+    const std::array<float, M>& other = turn == chess::side_black ? accumulator_white : accumulator_black;
+
+    std::array<float, 2 * M> z0;
+    std::copy(own.begin(), own.end(), z0.begin());
+    std::copy(other.begin(), other.end(), z0.begin() + M);
+    relu(z0.data(), 2 * M);
+
+    std::array<float, max_layer_size> z1;
+    l1.forward(z0.data(), z1.data());
+    relu(z1.data(), l1.outputs);
+
+    std::array<float, max_layer_size> z2;
+    l2.forward(z1.data(), z2.data());
+    relu(z2.data(), l2.outputs);
 
-    accumulator_white = torch::clone(other.accumulator_white);
-    accumulator_black = torch::clone(other.accumulator_black);
+    std::array<float, max_layer_size> output;
+    l3.forward(z2.data(), output.data());
 
-    white_king_pos = other.white_king_pos;
-    black_king_pos = other.black_king_pos;
+    return output[0];
 }
 
-void NNUE::accumulator::refresh(const evaluator& eval, enum perspective perspective, const chess::position & pos) {
-    
-    torch::Tensor encoding = torch::zeros(64*64*10);
-    halfkp_encode(encoding, pos, perspective);
-    encoding = encoding.unsqueeze(1);
+const float* NNUE::evaluator::feature_weights(int feature) const {
+    return l0_weights.data() + static_cast<std::size_t>(feature) * M;
+}
 
-    if(perspective == white) {
-        accumulator_white = torch::matmul(eval.l0_weights,encoding).squeeze() + eval.l0_biases;
+const std::array<float, M>& NNUE::evaluator::input_biases() const {
+    return l0_biases;
+}
+
+void NNUE::accumulator::add_feature(std::array<float, M>& values, const evaluator& eval, int feature) {
+    const float* weights = eval.feature_weights(feature);
+
+    for(int i = 0; i < M; i++) {
+        values[i] += weights[i];
     }
-    else {
-        accumulator_black = torch::matmul(eval.l0_weights,encoding).squeeze() + eval.l0_biases;
+}
+
+void NNUE::accumulator::remove_feature(std::array<float, M>& values, const evaluator& eval, int feature) {
+    const float* weights = eval.feature_weights(feature);
+
+    for(int i = 0; i < M; i++) {
+        values[i] -= weights[i];
     }
+}
+
+void NNUE::accumulator::refresh(const evaluator& eval, enum perspective perspective, const chess::position & pos) {
 
     const chess::board& board = pos.get_board();
 
@@ -72,22 +136,37 @@ void NNUE::accumulator::refresh(const evaluator& eval, enum perspective perspect
             black_king_pos = (chess::square)i;
         }
     }
+
+    // The biases plus the weights of every active feature, the pieces other than kings seen from the king of the perspective
+    std::array<float, M>& values = perspective == white ? accumulator_white : accumulator_black;
+    values = eval.input_biases();
+
+    for(int sq = 0; sq < 64; sq++) {
+        std::pair<chess::side, chess::piece> side_piece = board.get((chess::square)sq);
+
+        if(side_piece.second == chess::piece_none || side_piece.second == chess::piece_king) {
+            continue;
+        }
+
+        if(perspective == white) {
+            add_feature(values, eval, get_halfkp_idx(side_piece.second, (chess::square)sq, white_king_pos, side_piece.first));
+        }
+        else {
+            add_feature(values, eval, get_halfkp_idx(side_piece.second, (chess::square)reverse_idx(sq), (chess::square)reverse_idx(black_king_pos), (chess::side)(side_piece.first != chess::side_black)));
+        }
+    }
 }
 
 void NNUE::accumulator::update(const evaluator& eval, enum perspective perspective, const chess::move& move, const chess::position& position) {
 
-    const chess::board board = position.get_board();
+    const chess::board& board = position.get_board();
 
     std::pair<chess::side, chess::piece> moved_piece = board.get(move.from);
     std::pair<chess::side, chess::piece> captured_piece = board.get(move.to);
 
-    moved_piece.second = moved_piece.second;
-    captured_piece.second = captured_piece.second;
-
-    chess::position new_pos = position.copy_move(move);
-
-    bool king_side_castling = ((moved_piece.second == chess::piece_king) && (new_pos.get_board().get((chess::square)((int)move.from + 1)).second == chess::piece_rook) && position.get_board().get((chess::square)((int)move.from + 1)).second != chess::piece_rook);
-    bool queen_side_castling = ((moved_piece.second == chess::piece_king) && (new_pos.get_board().get((chess::square)((int)move.from - 1)).second == chess::piece_rook) && position.get_board().get((chess::square)((int)move.from - 1)).second != chess::piece_rook);
+    // Castling is the only king move of two squares, it puts the rook next to where the king was
+    bool king_side_castling = moved_piece.second == chess::piece_king && (int)move.to == (int)move.from + 2;
+    bool queen_side_castling = moved_piece.second == chess::piece_king && (int)move.to == (int)move.from - 2;
 
     int idx;
 
@@ -98,7 +177,7 @@ void NNUE::accumulator::update(const evaluator& eval, enum perspective perspecti
             
             // Remove moved piece
             idx = get_halfkp_idx(moved_piece.second, move.from, white_king_pos, moved_piece.first);
-            accumulator_white -= eval.l0_weights.index({Slice(), idx});
+            remove_feature(accumulator_white, eval, idx);
 
             // Add new position (check if promoted)
             chess::piece new_piece = moved_piece.second;
@@ -107,31 +186,31 @@ void NNUE::accumulator::update(const evaluator& eval, enum perspective perspecti
             }
 
             idx = get_halfkp_idx(new_piece, move.to, white_king_pos, moved_piece.first);
-            accumulator_white += eval.l0_weights.index({Slice(), idx});
+            add_feature(accumulator_white, eval, idx);
         }
         else if(king_side_castling) {
             // Add rook 
             idx = get_halfkp_idx(chess::piece_rook, (chess::square)((int)move.from + 1), white_king_pos, chess::side_black);
-            accumulator_white += eval.l0_weights.index({Slice(), idx});
+            add_feature(accumulator_white, eval, idx);
 
             // Remove rook 
             idx = get_halfkp_idx(chess::piece_rook, (chess::square)63, white_king_pos, chess::side_black);
-            accumulator_white -= eval.l0_weights.index({Slice(), idx});
+            remove_feature(accumulator_white, eval, idx);
         }
         else if(queen_side_castling) {
              // Add rook
             idx = get_halfkp_idx(chess::piece_rook, (chess::square)((int)move.from - 1), white_king_pos, chess::side_black);
-            accumulator_white += eval.l0_weights.index({Slice(), idx});
+            add_feature(accumulator_white, eval, idx);
 
             // Remove rook 
             idx = get_halfkp_idx(chess::piece_rook, (chess::square)56, white_king_pos, chess::side_black);
-            accumulator_white -= eval.l0_weights.index({Slice(), idx});
+            remove_feature(accumulator_white, eval, idx);
         }
 
         // Remove taken
         if (captured_piece.second != chess::piece_none) {
             idx = get_halfkp_idx(captured_piece.second, move.to, white_king_pos, captured_piece.first);
-            accumulator_white -= eval.l0_weights.index({Slice(), idx});
+            remove_feature(accumulator_white, eval, idx);
         }
     } 
    else {
@@ -139,7 +218,7 @@ void NNUE::accumulator::update(const evaluator& eval, enum perspective perspecti
 
             // Remove moved piece
             idx = get_halfkp_idx(moved_piece.second, (chess::square)reverse_idx(move.from), (chess::square)reverse_idx(black_king_pos), (chess::side)(moved_piece.first != chess::side_black));
-            accumulator_black -= eval.l0_weights.index({Slice(), idx});
+            remove_feature(accumulator_black, eval, idx);
 
             //Add new position (check if promoted)
             chess::piece new_piece = moved_piece.second;
@@ -148,212 +227,42 @@ void NNUE::accumulator::update(const evaluator& eval, enum perspective perspecti
             }
 
             idx = get_halfkp_idx(new_piece, (chess::square)reverse_idx(move.to), (chess::square)reverse_idx(black_king_pos), (chess::side)(moved_piece.first != chess::side_black));
-            accumulator_black += eval.l0_weights.index({Slice(), idx});
+            add_feature(accumulator_black, eval, idx);
         }
         else if(king_side_castling) {
             // Add rook 
             idx = get_halfkp_idx(chess::piece_rook, (chess::square)reverse_idx((chess::square)((int)move.from + 1)), (chess::square)reverse_idx(black_king_pos), chess::side(1));
-            accumulator_black += eval.l0_weights.index({Slice(), idx});
+            add_feature(accumulator_black, eval, idx);
 
             // Remove rook 
             idx = get_halfkp_idx(chess::piece_rook, (chess::square)reverse_idx((chess::square)7), (chess::square)reverse_idx(black_king_pos), chess::side(1));
-            accumulator_black -= eval.l0_weights.index({Slice(), idx});
+            remove_feature(accumulator_black, eval, idx);
         }
         else if(queen_side_castling) {
             // Add rook 
             idx = get_halfkp_idx(chess::piece_rook, (chess::square)reverse_idx((chess::square)((int)move.from - 1)), (chess::square)reverse_idx(black_king_pos), chess::side(1));
-            accumulator_black += eval.l0_weights.index({Slice(), idx});
+            add_feature(accumulator_black, eval, idx);
 
             // Remove rook 
             idx = get_halfkp_idx(chess::piece_rook, (chess::square)reverse_idx((chess::square)0), (chess::square)reverse_idx(black_king_pos), chess::side(1));
-            accumulator_black -= eval.l0_weights.index({Slice(), idx});
+            remove_feature(accumulator_black, eval, idx);
         }
         
 
         // Remove taken
         if (captured_piece.second != chess::piece_none) {
             idx = get_halfkp_idx(captured_piece.second, (chess::square)reverse_idx(move.to), (chess::square)reverse_idx(black_king_pos), (chess::side)(captured_piece.first != chess::side_black));
-            accumulator_black -= eval.l0_weights.index({Slice(), idx});
+            remove_feature(accumulator_black, eval, idx);
         }
     }     
 }
 
 void NNUE::accumulator::print_accumulator(enum perspective perspective) {
-    if(perspective == white) {
-        std::cout << accumulator_white << std::endl;
-    }
-    else {
-        std::cout << accumulator_black << std::endl;
-    }
-    
-}
+    const std::array<float, M>& values = perspective == white ? accumulator_white : accumulator_black;
 
-chess::bitboard NNUE::accumulator::bitboard_mirror(chess::bitboard bb) {
-    chess::bitboard flipped_bb = 0;
-    for (int i = 0; i < chess::files; i++) {
-        flipped_bb |= ((((bb >> (((chess::ranks - 1) - i) * chess::files))) & 255) << i * chess::files);
+    for(float value: values) {
+        std::cout << value << ' ';
     }
 
-    return flipped_bb;
-}
-
-void NNUE::accumulator::halfkp_encode(torch::Tensor& features, const chess::position & pos, enum perspective perspective) {
-    const chess::board& board = pos.get_board();
-
-    // bitboards for kings
-    chess::bitboard bb_wk = board.piece_set(chess::piece_king, chess::side_white);
-    chess::bitboard bb_bk = board.piece_set(chess::piece_king, chess::side_black);
-
-    // bitboards for all non king pieces
-    std::vector<chess::bitboard> bitboards;
-    bitboards.push_back(board.piece_set(chess::piece_pawn, chess::side_white));
-    bitboards.push_back(board.piece_set(chess::piece_knight, chess::side_white));
-    bitboards.push_back(board.piece_set(chess::piece_bishop, chess::side_white));
-    bitboards.push_back(board.piece_set(chess::piece_rook, chess::side_white));
-    bitboards.push_back(board.piece_set(chess::piece_queen, chess::side_white));
-    bitboards.push_back(board.piece_set(chess::piece_pawn, chess::side_black));
-    bitboards.push_back(board.piece_set(chess::piece_knight, chess::side_black));
-    bitboards.push_back(board.piece_set(chess::piece_bishop, chess::side_black));
-    bitboards.push_back(board.piece_set(chess::piece_rook, chess::side_black));
-    bitboards.push_back(board.piece_set(chess::piece_queen, chess::side_black));
-
-    int halfkp_idx = 0;
-
-    if(pos.get_turn() == chess::side_white) {
-        if(perspective == white) {
-            // white king
-            for(int king_sq = 0; king_sq < 64; king_sq++) {
-                if(((bb_wk >> king_sq) & 1) == 0) {
-                    halfkp_idx += 64 * 10;
-                    continue;
-                }
-                
-                // white pieces
-                for(int p = 0; p < 5; p++) {
-                    for(int piece_sq = 0; piece_sq < 64; piece_sq++) {
-                        if(((bitboards[p] >> piece_sq) & 1) == 1) {
-                            features[halfkp_idx] = 1;
-                        }
-
-                        halfkp_idx++;
-                    }
-                }
-
-                // black pieces
-                for(int p = 5; p < 10; p++) {
-                    for(int piece_sq = 0; piece_sq < 64; piece_sq++) {
-                        if(((bitboards[p] >> piece_sq) & 1) == 1) {
-                            features[halfkp_idx] = 1;
-                        }
-
-                        halfkp_idx++;
-                    }
-                }
-            }
-            return;
-        }
-        // black perspective
-        else {
-            // black king
-            for(int king_sq = 0; king_sq < 64; king_sq++) {
-                if(((bitboard_mirror(bb_bk) >> king_sq) & 1) == 0) {
-                    halfkp_idx += 64 * 10;
-                    continue;
-                }
-                            
-                // black pieces
-                for(int p = 5; p < 10; p++) {
-                    for(int piece_sq = 0; piece_sq < 64; piece_sq++) {
-                        if(((bitboard_mirror(bitboards[p]) >> piece_sq) & 1) == 1) {
-                            features[halfkp_idx] = 1;
-                        }
-
-                        halfkp_idx++;
-                    }
-                }
-
-                // white pieces
-                for(int p = 0; p < 5; p++) {
-                    for(int piece_sq = 0; piece_sq < 64; piece_sq++) {
-                        if(((bitboard_mirror(bitboards[p]) >> piece_sq) & 1) == 1) {
-                            features[halfkp_idx] = 1;
-                        }
-
-                        halfkp_idx++;
-                    }
-                }
-            }
-            return;
-        }
-    }   
-    // Black turn
-    else {
-        if(perspective == black) {
-            // black king
-            for(int king_sq = 0; king_sq < 64; king_sq++) {
-                if(((bitboard_mirror(bb_bk) >> king_sq) & 1) == 0) {
-                    halfkp_idx += 64 * 10;
-                    continue;
-                }
-                
-                // black pieces
-                for(int p = 5; p < 10; p++) {
-                    for(int piece_sq = 0; piece_sq < 64; piece_sq++) {
-                        if(((bitboard_mirror(bitboards[p]) >> piece_sq) & 1) == 1) {
-                            features[halfkp_idx] = 1;
-                        }
-
-                        halfkp_idx++;
-                    }
-                }
-
-                // white pieces
-                for(int p = 0; p < 5; p++) {
-                    for(int piece_sq = 0; piece_sq < 64; piece_sq++) {
-                        if(((bitboard_mirror(bitboards[p]) >> piece_sq) & 1) == 1) {
-                            features[halfkp_idx] = 1;
-                        }
-
-                        halfkp_idx++;
-                    }
-                }
-            }
-            return;
-        }
-        // white persepctive
-        else {
-            // white king
-            for(int king_sq = 0; king_sq < 64; king_sq++) {
-                if(((bb_wk >> king_sq) & 1) == 0) {
-                    halfkp_idx += 64 * 10;
-                    continue;
-                }
-                
-                // white pieces
-                for(int p = 0; p < 5; p++) {
-                    for(int piece_sq = 0; piece_sq < 64; piece_sq++) {
-                        if(((bitboards[p] >> piece_sq) & 1) == 1) {
-                            features[halfkp_idx] = 1;
-                        }
-
-                        halfkp_idx++;
-                    }
-                }
-
-                // black pieces
-                for(int p = 5; p < 10; p++) {
-                    for(int piece_sq = 0; piece_sq < 64; piece_sq++) {
-                        if(((bitboards[p] >> piece_sq) & 1) == 1) {
-                            features[halfkp_idx] = 1;
-                        }
-
-                        halfkp_idx++;
-                    }
-                }
-            }
-            return;
-        }
-    }
+    std::cout << std::endl;
 }
-
-
@@ -2,7 +2,9 @@
 #define NNUE_H
 
 #include <torch/torch.h>
+#include <array>
 #include <string>
+#include <vector>
 #include <chess/chess.hpp>
 
 #define M 256
@@ -15,33 +17,58 @@ enum perspective {
     black
 };
 
+// HalfKP inputs: king square, 10 kinds of non-king pieces, piece square.
+constexpr int features = 64 * 64 * 10;
+
+// Room for the outputs of a hidden layer, evaluating uses fixed buffers of this size.
+constexpr int max_layer_size = 2 * M;
+
+// Fully connected layer, copied out of its torch parameters once so that running it allocates nothing.
+struct layer {
+    int inputs = 0;
+    int outputs = 0;
+    std::vector<float> weights;
+    std::vector<float> biases;
+
+    void load(const std::string& weights_path, const std::string& biases_path);
+
+    // output = weights * input + biases
+    void forward(const float* input, float* output) const;
+};
+
 class evaluator {
 public:
     evaluator(const std::string path);
 
-    float forward(torch::Tensor accumulator_white, torch::Tensor accumulator_black, chess::side turn);
-    torch::Tensor l0_weights, l1_weights, l2_weights, l3_weights, l0_biases, l1_biases, l2_biases, l3_biases;    
+    float forward(const std::array<float, M>& accumulator_white, const std::array<float, M>& accumulator_black, chess::side turn) const;
+
+    // Column of the input layer weights for a feature, added to an accumulator when the feature becomes active.
+    const float* feature_weights(int feature) const;
+
+    const std::array<float, M>& input_biases() const;
+
+private:
+    // Input layer stored feature after feature, so that a column is contiguous
+    std::vector<float> l0_weights;
+    std::array<float, M> l0_biases;
+    layer l1, l2, l3;
 };
 
 class accumulator {
 public:
-    accumulator() = default;
-    accumulator(const accumulator& other);
-
     void update(const evaluator& eval, enum perspective perspective, const chess::move& move,  const chess::position& position);
     void refresh(const evaluator& eval, enum perspective perspective, const chess::position& pos);
     void print_accumulator(enum perspective perspective);
     
-    torch::Tensor accumulator_white = torch::zeros(M);
-    torch::Tensor accumulator_black = torch::zeros(M);
+    std::array<float, M> accumulator_white{};
+    std::array<float, M> accumulator_black{};
 
 private:
     chess::square white_king_pos{chess::square_e1};
     chess::square black_king_pos{chess::square_e8};
-    
-    chess::bitboard bitboard_mirror(chess::bitboard bb);
 
-    void halfkp_encode(torch::Tensor& result, const chess::position & pos, enum perspective perspective);
+    static void add_feature(std::array<float, M>& values, const evaluator& eval, int feature);
+    static void remove_feature(std::array<float, M>& values, const evaluator& eval, int feature);
 
     inline int get_halfkp_idx(const chess::piece& piece_type, const chess::square& piece_square, const chess::square& king_square, const chess::side& side) { 
         return 640*king_square + 320*side + 64*map_piece_idx(piece_type) + piece_square; 
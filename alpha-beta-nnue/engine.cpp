@@ -3,36 +3,94 @@
 #include <atomic>
 #include <chrono>
 #include <optional>
+#include <cmath>
 #include <cstring>
+#include <algorithm>
+#include <bit>
+#include <thread>
+#include <memory>
 #include <sstream>
+#include <iostream>
 #include <chess/chess.hpp>
 #include <uci/uci.hpp>
 
+#include <search/allocations.hpp>
+#include <search/attack.hpp>
+#include <search/move_picker.hpp>
+#include <search/movegen.hpp>
+#include <search/values.hpp>
+#include <search/score.hpp>
+#include <search/null_move.hpp>
+#include <search/time_manager.hpp>
+#include <search/search_stats.hpp>
+
 #include "engine.hpp"
 #include "new_eval.hpp"
 
-alpha_beta_engine::alpha_beta_engine() : root(), evaluator("../evaluation-model/models/params/") {
+alpha_beta_engine::alpha_beta_engine() : root(), game_history(), evaluator("../evaluation-model/models/params/"), accumulators(), table(default_hash_mb), threads(), timer(time_poll_nodes), search_moves(), book(), book_path(), book_random(std::random_device()()), syzygy_path(), tablebase_limit(0), node_limit(0), limit_reached(false), pondering(nullptr), multi_pv(1), reductions(), lmr_enabled(true), lmr_min_depth(3), lmr_min_moves(3), rfp_enabled(true), rfp_depth(6), rfp_margin(80), futility_enabled(true), futility_depth(2), futility_margin(120), razoring_enabled(true), razoring_depth(2), razoring_margin(250), lmp_enabled(true), lmp_depth(3), lmp_base(3) {
 	
     // most clients require these options
-	opt.add<uci::option_spin>("MultiPV", 1, 1, 1);
-	opt.add<uci::option_spin>("Move Overhead", 0, 0, 1);
-	opt.add<uci::option_spin>("Threads", 1, 1, 1);
-	opt.add<uci::option_spin>("Hash", 1, 1, 1);
+	opt.add<uci::option_check>("Ponder", false);
+	opt.add<uci::option_spin>("MultiPV", 1, 1, max_multi_pv);
+	opt.add<uci::option_spin>("Move Overhead", default_move_overhead, 0, 5000);
+	opt.add<uci::option_spin>("Threads", 1, 1, max_threads);
+	opt.add<uci::option_spin>("Hash", default_hash_mb, 1, 4096);
+
+	// counters of the search are always reported after go, this also writes them to stderr as one JSON line
+	opt.add<uci::option_check>("Search Stats JSON", false);
+
+	// polyglot opening book, played by weight or always the best move
+	opt.add<uci::option_string>("Book File", "");
+	opt.add<uci::option_check>("Book Best Move", false);
+
+	// syzygy endgame tablebases, directories separated by ':'. The search only probes positions with at most
+	// SyzygyProbeLimit pieces, and the tables only answer those right after a capture or pawn move (fifty-move counter 0)
+	opt.add<uci::option_string>("SyzygyPath", "");
+	opt.add<uci::option_spin>("SyzygyProbeLimit", 7, 0, 7);
+
+	// late move reductions, base and divisor in hundredths of a ply
+	opt.add<uci::option_check>("LMR", true);
+	opt.add<uci::option_spin>("LMR Min Depth", 3, 1, 64);
+	opt.add<uci::option_spin>("LMR Min Moves", 3, 1, 64);
+	opt.add<uci::option_spin>("LMR Base", 75, 0, 500);
+	opt.add<uci::option_spin>("LMR Divisor", 225, 50, 1000);
+
+	// forward pruning, margins in centipawns per ply of depth
+	opt.add<uci::option_check>("RFP", true);
+	opt.add<uci::option_spin>("RFP Depth", 6, 1, 64);
+	opt.add<uci::option_spin>("RFP Margin", 80, 0, 1000);
+	opt.add<uci::option_check>("Futility", true);
+	opt.add<uci::option_spin>("Futility Depth", 2, 1, 64);
+	opt.add<uci::option_spin>("Futility Margin", 120, 0, 1000);
+	opt.add<uci::option_check>("Razoring", true);
+	opt.add<uci::option_spin>("Razoring Depth", 2, 1, 64);
+	opt.add<uci::option_spin>("Razoring Margin", 250, 0, 1000);
+	opt.add<uci::option_check>("LMP", true);
+	opt.add<uci::option_spin>("LMP Depth", 3, 1, 64);
+	opt.add<uci::option_spin>("LMP Base", 3, 0, 256);
 }   
 
 
 void alpha_beta_engine::setup(const chess::position& position, const std::vector<chess::move>& moves) {
 	root = position;
+	game_history.clear();
+	game_history.push(root.hash(), root.get_halfmove_clock());
 
 	for(const chess::move& move: moves)
 	{
 		root.make_move(move);
+		game_history.push(root.hash(), root.get_halfmove_clock());
+		game_history.drop_unreachable();
 	}
 }
 
 
 void alpha_beta_engine::reset() {
-    return;
+    table.clear();
+
+    for(auto& thread: threads) {
+        thread->order.clear();
+    }
 }
 
 
@@ -40,130 +98,415 @@ uci::search_result alpha_beta_engine::search(const uci::search_limit& limit, uci
     
     info.message("search started");
 
+    // A book move is played at once, without starting the clock or the threads
+    if(std::optional<chess::move> move = book_move(limit, ponder, info)) {
+        info.message("book move");
+        return {*move, std::nullopt};
+    }
+
+    std::string path = opt.get<uci::option_string>("SyzygyPath");
+
+    if(path != syzygy_path) {
+        syzygy_path = path;
+        info.message("tablebases up to " + std::to_string(search::tablebase_init(path)) + " pieces");
+    }
+
+    tablebase_limit = std::min<int>(opt.get<uci::option_spin>("SyzygyProbeLimit"), search::tablebase_pieces());
+
+    // A root in the tables is decided by them: the move that keeps the result and zeroes the fifty-move count soonest (DTZ)
+    if(tablebase_limit > 0 && !limit.infinite && !ponder && limit.moves.empty()
+        && std::popcount(search::occupied_set(root.get_board())) <= tablebase_limit)
+    {
+        search::wdl root_result;
+
+        if(std::optional<chess::move> move = search::probe_root(root, root_result))
+        {
+            // Reported like a tablebase win found by the search, cursed wins and blessed losses are draws
+            search::score_t value = 0;
+
+            if(root_result == search::wdl::win)
+            {
+                value = search::tablebase_win_in(0);
+            }
+            else if(root_result == search::wdl::loss)
+            {
+                value = -search::tablebase_win_in(0);
+            }
+
+            info.score(value);
+            info.line({*move});
+            info.message("tablebase move");
+            return {*move, std::nullopt};
+        }
+    }
+
 	// UCI setup
 	chess::side side = root.get_turn();
-	std::vector<chess::move> moves = root.moves();
-	std::vector<chess::move> best_line;
-	float max_time = std::min(limit.time, limit.clocks[side] / 100); // estimate ~100 moves per game
-	std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+	timer.start(limit, side, opt.get<uci::option_spin>("Move Overhead") / 1000.0);
 
-    chess::move best_move;
-    chess::move move = chess::move();
-    bool has_completed_first = false;
+    // Resizing throws away all entries, so only do it when the option changed
+    std::size_t hash_mb = opt.get<uci::option_spin>("Hash");
+    if(hash_mb != table.megabytes()) {
+        table.resize(hash_mb);
+    }
 
-    double * prev_evaluated = new double[table_size]();
+    // Lazy SMP: every thread searches the same root and they share what they find through the transposition table
+    std::size_t thread_count = opt.get<uci::option_spin>("Threads");
 
-    for (int eval_depth = 0;; eval_depth++) {
+    while(threads.size() < thread_count) {
+        threads.push_back(std::make_unique<search::thread_data>());
+    }
+    threads.resize(thread_count);
+
+    for(std::size_t i = 0; i < threads.size(); i++) {
+        threads[i]->id = static_cast<int>(i);
+        threads[i]->random.seed(static_cast<unsigned>(i));
+        threads[i]->nodes.store(0, std::memory_order_relaxed);
+        threads[i]->tree_allocations = 0;
+        threads[i]->order.new_search();
+        threads[i]->picker_stats.clear();
+        threads[i]->stats.clear();
+        threads[i]->history = game_history;
+    }
 
-        if(eval_depth > 0) {
-            best_move = move;
-            has_completed_first = true;
-        }
+    accumulators.resize(threads.size());
+
+    for(std::vector<NNUE::accumulator>& stack: accumulators) {
+        stack.resize(search::max_ply);
+    }
+
+    // Limits of the go command other than time
+    search_moves = limit.moves;
+    node_limit = limit.nodes ? static_cast<unsigned long long>(std::max(*limit.nodes, 1)) : 0;
+    limit_reached = false;
+    pondering = &ponder;
+
+    std::vector<chess::move> root_moves = root.moves();
+
+    // A searchmoves list without a legal move is ignored, since a move has to be sent
+    if(std::none_of(root_moves.begin(), root_moves.end(), [&](const chess::move& move) {
+        return std::any_of(search_moves.begin(), search_moves.end(), [&](const chess::move& allowed) {
+            return search::same_move(allowed, move);
+        });
+    })) {
+        search_moves.clear();
+    }
 
-        double * states_evaluated = new double[table_size]();
+    // Asking for more lines than there are moves gives all of them
+    int allowed_moves = search_moves.empty() ? static_cast<int>(root_moves.size()) : static_cast<int>(std::count_if(root_moves.begin(), root_moves.end(), [&](const chess::move& move) {
+        return std::any_of(search_moves.begin(), search_moves.end(), [&](const chess::move& allowed) {
+            return search::same_move(allowed, move);
+        });
+    }));
+    multi_pv = std::max(1, std::min<int>(opt.get<uci::option_spin>("MultiPV"), allowed_moves));
+
+    lmr_enabled = opt.get<uci::option_check>("LMR");
+    lmr_min_depth = opt.get<uci::option_spin>("LMR Min Depth");
+    lmr_min_moves = opt.get<uci::option_spin>("LMR Min Moves");
+    reductions.init(opt.get<uci::option_spin>("LMR Base") / 100.0, opt.get<uci::option_spin>("LMR Divisor") / 100.0);
+
+    rfp_enabled = opt.get<uci::option_check>("RFP");
+    rfp_depth = opt.get<uci::option_spin>("RFP Depth");
+    rfp_margin = opt.get<uci::option_spin>("RFP Margin");
+    futility_enabled = opt.get<uci::option_check>("Futility");
+    futility_depth = opt.get<uci::option_spin>("Futility Depth");
+    futility_margin = opt.get<uci::option_spin>("Futility Margin");
+    razoring_enabled = opt.get<uci::option_check>("Razoring");
+    razoring_depth = opt.get<uci::option_spin>("Razoring Depth");
+    razoring_margin = opt.get<uci::option_spin>("Razoring Margin");
+    lmp_enabled = opt.get<uci::option_check>("LMP");
+    lmp_depth = opt.get<uci::option_spin>("LMP Depth");
+    lmp_base = opt.get<uci::option_spin>("LMP Base");
+
+#ifdef SEARCH_DIAGNOSTICS
+    unsigned long long allocations_start = search::allocation_count();
+#endif
+
+    // Helpers run until the main thread is done, the main thread alone decides the move
+    std::atomic_bool helpers_stop = false;
+    std::vector<std::thread> helpers;
+
+    for(std::size_t i = 1; i < threads.size(); i++) {
+        helpers.emplace_back([&, i]() {
+            uci::search_info helper_info;
+            iterative_deepening(*threads[i], limit, helper_info, helpers_stop);
+        });
+    }
 
-        move = alpha_beta_search(root, eval_depth, states_evaluated, prev_evaluated, info, stop, start_time, max_time);
+    uci::search_result result = iterative_deepening(*threads.front(), limit, info, stop);
 
-        info.depth(eval_depth);
+    helpers_stop = true;
 
-        std::memcpy(prev_evaluated, states_evaluated, table_size*sizeof(double));
-        delete[] states_evaluated;
+    for(std::thread& helper: helpers) {
+        helper.join();
+    }
 
-        // Check if enough time has passed
-        auto current_time = std::chrono::steady_clock::now();
-        std::chrono::duration<double> elapsed_time = current_time - start_time;
-		if (stop || elapsed_time.count() > max_time) {
-             
-             // In case the first iteration got interrupted
-            if(!has_completed_first) {
-                best_move = move;
-            }
-			break;
-		}
+    // With go infinite, or while pondering, the move may only be sent after stop or ponderhit, even if the search has nothing left to do
+    while((limit.infinite || ponder) && !stop) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
     }
 
-    
-    delete[] prev_evaluated;
+    // Counters of all threads, the iterations are those of the main thread
+    search::search_stats stats = threads.front()->stats;
 
-    
-    // Set info
-    best_line.clear();
-    best_line.push_back(best_move);
+    for(std::size_t i = 1; i < threads.size(); i++) {
+        stats += threads[i]->stats;
+    }
 
-    // Check if enough time has passed
-    auto current_time = std::chrono::steady_clock::now();
-    std::chrono::duration<double> elapsed_time = current_time - start_time;
+    stats.nodes = searched_nodes();
+    info.message(stats.to_string());
+    info.message(stats.iterations_to_string());
 
-    return {best_move, std::nullopt};
+    if(opt.get<uci::option_check>("Search Stats JSON")) {
+        std::cerr << stats.to_json() << std::endl;
+    }
+
+#ifdef SEARCH_DIAGNOSTICS
+    info.message(threads.front()->picker_stats.to_string());
+
+    // Those of the main thread, all at the root: move lists, principal variations and starting the helpers
+    info.message("allocations " + std::to_string(search::allocation_count() - allocations_start) + " below the root " + std::to_string(search_allocations())
+                 + " nodes " + std::to_string(searched_nodes()));
+#endif
+
+    return result;
 }
 
 
-chess::move alpha_beta_engine::alpha_beta_search(chess::position state, int max_depth, double* states_evaluated, double* prev_evaluated,
-									uci::search_info& info, const std::atomic_bool& stop, const std::chrono::steady_clock::time_point& start_time, 
-									const float max_time) {
-    
+/**
+ * Iterative deepening with aspiration windows, run by every search thread. Returns the best move of the deepest finished iteration,
+ * and the reply expected to it to ponder on.
+ */
+uci::search_result alpha_beta_engine::iterative_deepening(search::thread_data& thread, const uci::search_limit& limit, uci::search_info& info,
+                                                   const std::atomic_bool& stop) {
+
+    chess::position state = root;
+    search::search_context context{thread, state, info, stop};
     chess::move best_move = chess::move();
-    double best_value = -inf;
+    std::vector<chess::move> best_line;
+    search::score_t score = 0;
+
+    // With MultiPV the main thread searches the root once per line, each time without the best moves of the lines before it.
+    // The lines share the transposition table and move ordering, so a later line mostly reuses the work of the earlier ones.
+    // Helper threads only search the best line.
+    int line_count = thread.id == 0 ? multi_pv : 1;
+    std::vector<search::score_t> line_scores(line_count, 0);
+
+    // Odd helper threads start one ply deeper, so that the threads are spread over two depths
+    int first_depth = 1 + thread.id % 2;
+
+    for (int depth = first_depth; depth < search::max_ply && (!limit.depth || depth <= *limit.depth); depth++) {
+
+        thread.seldepth = 0;
+
+        std::vector<chess::move> excluded;
+        std::vector<std::pair<search::score_t, std::vector<chess::move>>> lines;
+        chess::move move = chess::move();
+        search::score_t value = 0;
+
+        for (int line_index = 0; line_index < line_count; line_index++) {
+
+            // Search a window around the previous score, widen it on the failing side until the score fits
+            search::score_t delta = aspiration_window;
+            search::score_t alpha = depth > first_depth ? line_scores[line_index] - delta : -inf;
+            search::score_t beta = depth > first_depth ? line_scores[line_index] + delta : inf;
+
+            while (true) {
+                value = alpha_beta_search(context, depth, alpha, beta, move, excluded);
+
+                if (time_is_up(context)) {
+                    break;
+                }
+
+                if (value <= alpha && alpha > -inf) {
+                    beta = (alpha + beta) / 2;
+                    alpha = std::max(value - delta, -inf);
+                }
+                else if (value >= beta && beta < inf) {
+                    beta = std::min(value + delta, inf);
+                }
+                else {
+                    break;
+                }
+
+                delta *= 2;
+
+                // Give up on the window when the score keeps moving
+                if (delta > max_aspiration_window) {
+                    alpha = -inf;
+                    beta = inf;
+                }
+            }
 
-    chess::side own_side = state.get_turn();
+            if (time_is_up(context)) {
+                break;
+            }
 
-    int max_depth_quiescence = 2;
+            std::vector<chess::move> line = thread.principal_variation();
 
-    NNUE::accumulator accumulator{};
-    accumulator.refresh(evaluator, NNUE::white, state);
-    accumulator.refresh(evaluator, NNUE::black, state);
+            if (line.empty()) {
+                line.push_back(move);
+            }
 
-    for(chess::move move : state.moves()) {
+            line_scores[line_index] = value;
+            excluded.push_back(move);
+            lines.emplace_back(value, line);
+        }
 
-        NNUE::accumulator new_accumulator(accumulator);
-        set_accumulator(new_accumulator, move, state);
+        // An interrupted iteration is only trusted if there is nothing better, a finished first line always is
+        if (time_is_up(context)) {
+            if (!lines.empty()) {
+                best_move = excluded.front();
+                best_line = lines.front().second;
+            }
+            else if (depth == first_depth) {
+                best_move = move;
+            }
+            break;
+        }
 
-        chess::undo undo = state.make_move(move);
+        best_move = excluded.front();
+        best_line = lines.front().second;
+        score = lines.front().first;
 
-        double value = alpha_beta(state, own_side, 0, max_depth, max_depth_quiescence, -inf, inf, false, states_evaluated, prev_evaluated, info, stop, start_time, max_time, accumulator);
-        
-        state.undo_move(move, undo);
-        
-        if(value >= best_value) {
-            best_value = value;
-            best_move = move;
-        }
+        if (thread.id == 0) {
+            // Search instability can leave a later line above an earlier one
+            std::stable_sort(lines.begin(), lines.end(), [](const auto& a, const auto& b) {
+                return a.first > b.first;
+            });
+
+            for (std::size_t i = 0; i < lines.size(); i++) {
+                report_iteration(thread, depth, static_cast<int>(i) + 1, lines[i].first, lines[i].second, info);
+            }
+
+            thread.stats.add_iteration(depth, searched_nodes(), timer.elapsed());
 
-        // Check if enough time has passed
-        auto current_time = std::chrono::steady_clock::now();
-        std::chrono::duration<double> elapsed_time = current_time - start_time;
-		if (stop || elapsed_time.count() > max_time) {
-			break;
-		}
+            // Stop once a mate within the asked number of moves is found
+            if (limit.mate && !limit.infinite && score >= search::mate_bound && search::mate_moves(score) <= *limit.mate) {
+                break;
+            }
+
+            // An iteration that would run past the soft limit is not started, it would most likely be cut off unfinished.
+            // While pondering the search goes on, after ponderhit the time already spent counts against the limits.
+            timer.iteration_done(best_move);
+
+            if (!*pondering && !timer.can_start_iteration()) {
+                break;
+            }
+        }
     }
 
-    return best_move;
+    return {best_move, ponder_move(thread.stats, best_move, best_line)};
 }
 
 
-void alpha_beta_engine::child_state_evals(chess::position& state, chess::side own_side, double* prev_evaluated, bool quiescence_search,
-							std::vector<std::pair<chess::move, double>>& output, const NNUE::accumulator& accumulator) {
-        
-    for (chess::move move : state.moves()) {
-        
-        NNUE::accumulator new_accumulator(accumulator);
+/**
+ * Principal variation search of the root. All moves are searched since the best one has to be returned.
+ */
+search::score_t alpha_beta_engine::alpha_beta_search(search::search_context& context, int depth, search::score_t alpha, search::score_t beta, chess::move& best_move,
+									const std::vector<chess::move>& excluded) {
+
+    search::thread_data& thread = context.thread;
+    chess::position& state = context.state;
+    search::score_t alpha_orig = alpha;
+
+    thread.count_node();
+    thread.pv_length[0] = 0;
+
+    NNUE::accumulator& accumulator = accumulators[thread.id][0];
+    accumulator.refresh(evaluator, NNUE::white, state);
+    accumulator.refresh(evaluator, NNUE::black, state);
+
+    // Start with the best move of the previous iteration
+    search::score_t table_value;
+    chess::move table_move;
+    table_probe(thread.stats, state, depth, 0, alpha, beta, table_value, table_move);
+
+    std::vector<std::pair<chess::move, double>> moves;
+    thread.order.score(state, table_move, 0, chess::move(), moves);
+    sort(moves.begin(), moves.end(), sort_descending);
+
+    // With go searchmoves only the listed moves are searched
+    if(!search_moves.empty()) {
+        std::erase_if(moves, [&](const std::pair<chess::move, double>& entry) {
+            return std::none_of(search_moves.begin(), search_moves.end(), [&](const chess::move& allowed) {
+                return search::same_move(allowed, entry.first);
+            });
+        });
+    }
+
+    // Moves of the earlier MultiPV lines are left out
+    std::erase_if(moves, [&](const std::pair<chess::move, double>& entry) {
+        return std::any_of(excluded.begin(), excluded.end(), [&](const chess::move& found) {
+            return search::same_move(found, entry.first);
+        });
+    });
+
+    // Helper threads try the moves after the first in their own order, so that they do not only repeat the main thread
+    if(thread.id > 0 && moves.size() > 2) {
+        std::shuffle(moves.begin() + 1, moves.end(), thread.random);
+    }
+
+    search::score_t best_value = -inf;
+    best_move = moves.empty() ? chess::move() : moves.front().first;
+
+    for(size_t i = 0; i < moves.size(); i++) {
+        const chess::move& move = moves[i].first;
+        thread.current_line[0] = move;
+        thread.pv_length[1] = 1;
+
+        // Everything below the root works in memory set aside before the search, debug builds check that it stays so
+        unsigned long long allocations = search::allocation_count();
+
+        NNUE::accumulator& new_accumulator = accumulators[thread.id][1];
+        new_accumulator = accumulator;
         set_accumulator(new_accumulator, move, state);
-        
+
         chess::undo undo = state.make_move(move);
+        thread.history.push(state.hash(), state.get_halfmove_clock());
 
-        double value;
-        int index = state.hash() & key_mask;
+        search::score_t value;
 
-        if (prev_evaluated[index] == 0) {
-            value = evaluate(new_accumulator, own_side);
-        } else {
-            value = prev_evaluated[index];
+        if(i == 0) {
+            value = -alpha_beta<search::node_type::pv>(context, depth - 1, 1, -beta, -alpha, true, new_accumulator);
+        }
+        else {
+            value = -alpha_beta<search::node_type::non_pv>(context, depth - 1, 1, -alpha - null_window, -alpha, true, new_accumulator);
+
+            if(value > alpha && value < beta) {
+                value = -alpha_beta<search::node_type::pv>(context, depth - 1, 1, -beta, -alpha, true, new_accumulator);
+            }
         }
-        
-        output.push_back({move, value});
 
+        thread.history.pop();
         state.undo_move(move, undo);
+        thread.tree_allocations += search::allocation_count() - allocations;
+
+        if (time_is_up(context)) {
+            return best_value;
+        }
+        
+        if(value > best_value) {
+            best_value = value;
+            best_move = move;
+        }
+
+        if(value > alpha) {
+            alpha = value;
+            thread.update_pv(0, move);
+        }
+
+        if(alpha >= beta) {
+            break;
+        }
     }
+
+    // Without some of its moves the root has a different value
+    if(excluded.empty() && search_moves.empty()) {
+        table_store(state, depth, 0, alpha_orig, beta, best_value, best_move);
+    }
+
+    return best_value;
 }
 
 
@@ -197,226 +540,520 @@ void alpha_beta_engine::set_accumulator(NNUE::accumulator& new_acc, chess::move
 }
 
 
-double alpha_beta_engine::alpha_beta(chess::position& state, chess::side own_side, int depth, int max_depth, int max_depth_quiescence, double alpha, double beta, 
-                        bool max_player, double* states_evaluated, double* prev_evaluated, uci::search_info& info,
-						const std::atomic_bool& stop, const std::chrono::steady_clock::time_point& start_time, const float max_time,
-                        const NNUE::accumulator& accumulator) { 
+/**
+ * Negamax principal variation search. Scores are from the perspective of the side to move.
+ */
+template<search::node_type type>
+search::score_t alpha_beta_engine::alpha_beta(search::search_context& context, int depth, int ply, search::score_t alpha, search::score_t beta, bool allow_null,
+                        const NNUE::accumulator& accumulator) {
+
+    constexpr bool pv_node = type == search::node_type::pv;
+    search::thread_data& thread = context.thread;
+    chess::position& state = context.state;
+
+    // Horizon reached, resolve captures before trusting the evaluation
+    if (depth <= 0) {
+        return alpha_beta_quiescence<type>(context, 0, ply, alpha, beta, accumulator);
+    }
 
-    size_t pos_hash = state.hash() & key_mask;
+    thread.count_node();
+    thread.seldepth = std::max(thread.seldepth, ply);
 
-    // Uncomment to use quiescence search    
-    // if(depth >= max_depth && !is_stable(state)) {
-    //     double eval = alpha_beta_quiescence(state, own_side, 0, max_depth_quiescence, alpha, beta, max_player, states_evaluated, prev_evaluated, info, stop, 
-    //                                         start_time, max_time, accumulator);
-    //     states_evaluated[pos_hash] = eval;
-    //     return eval;
-    // }
+    if constexpr (pv_node) {
+        thread.pv_length[ply] = ply;
+    }
 
-    if (depth >= max_depth || is_terminal(state)) {
-        double eval = evaluate(accumulator, own_side);
-        states_evaluated[pos_hash] = eval;
-        return eval;
+    // Repeating a position or reaching the fifty-move rule draws, the game could go on the same way forever.
+    // In check the node is searched anyway, since being mated on the fiftieth move still loses, its children are all draws.
+    if (thread.history.is_repetition() || (state.get_halfmove_clock() >= search::fifty_move_plies && !search::in_check(state))) {
+        return 0;
     }
 
-    auto current_time = std::chrono::steady_clock::now();
-    std::chrono::duration<double> elapsed_time = current_time - start_time;
+    // Mate distance pruning: no line from here can beat being mated at this ply or mating at the next
+    alpha = std::max(alpha, search::mated_in(ply));
+    beta = std::min(beta, search::mate_in(ply + 1));
 
-    if (stop || elapsed_time.count() > max_time) {
-        double eval = evaluate(accumulator, own_side);
-        states_evaluated[pos_hash] = eval;
-        return eval;
+    if (alpha >= beta) {
+        return alpha;
     }
 
-    std::vector<std::pair<chess::move, double>> state_evals;
-    child_state_evals(state, own_side, prev_evaluated, false, state_evals, accumulator);
+    search::score_t alpha_orig = alpha;
+
+    search::score_t table_value;
+    chess::move table_move;
 
-    double value;
+    if (table_probe(thread.stats, state, depth, ply, alpha, beta, table_value, table_move)) {
+        thread.stats.tt_cutoffs++;
+        return table_value;
+    }
 
-    if(max_player) {
-        sort(state_evals.begin(), state_evals.end(), sort_descending);
+    // Endgame tables give the result of the position. A win is only a lower bound since a mate may be found,
+    // and a loss an upper bound, so the node is still searched if the bound does not decide the window.
+    if (tablebase_limit > 0 && std::popcount(search::occupied_set(state.get_board())) <= tablebase_limit) {
+        if (std::optional<search::wdl> result = search::probe_wdl(state, thread.current_line[ply - 1])) {
+            search::score_t tablebase_value = 0;
+            search::bound tablebase_bound = search::bound::exact;
 
-        value = -std::numeric_limits<double>::infinity();
+            if (*result == search::wdl::win) {
+                tablebase_value = search::tablebase_win_in(ply);
+                tablebase_bound = search::bound::lower;
+            }
+            else if (*result == search::wdl::loss) {
+                tablebase_value = -search::tablebase_win_in(ply);
+                tablebase_bound = search::bound::upper;
+            }
 
-        elapsed_time = std::chrono::steady_clock::now() - start_time;
+            if (tablebase_bound == search::bound::exact || (tablebase_bound == search::bound::lower && tablebase_value >= beta)
+                || (tablebase_bound == search::bound::upper && tablebase_value <= alpha)) {
+                // A window that gives the bound of the result
+                search::score_t store_alpha = tablebase_bound == search::bound::upper ? tablebase_value : -inf;
+                search::score_t store_beta = tablebase_bound == search::bound::lower ? tablebase_value : inf;
+                table_store(state, search::max_ply, ply, store_alpha, store_beta, tablebase_value, chess::move());
+                return tablebase_value;
+            }
+        }
+    }
 
-        for(size_t i = 0; i < state_evals.size() && (!stop && elapsed_time.count() < max_time); i++) {
-            auto state_eval = state_evals[i]; 
+    if (ply >= search::max_ply - 1) {
+        return evaluate(state, accumulator);
+    }
 
-            NNUE::accumulator new_accumulator(accumulator);
-            set_accumulator(new_accumulator, state_eval.first, state);
+    // Interrupted results are not stored since they are not searched to depth
+    if (time_is_up(context)) {
+        return evaluate(state, accumulator);
+    }
 
-            chess::undo undo = state.make_move(state_eval.first);
+    bool node_in_check = search::in_check(state);
+    search::score_t static_eval = node_in_check ? -inf : evaluate(state, accumulator);
+    thread.stack[ply].static_eval = static_eval;
 
-            
-            
-            value = std::max(value, alpha_beta(state, own_side, depth + 1, max_depth, max_depth_quiescence, alpha, beta, false, states_evaluated, 
-                            prev_evaluated, info, stop, start_time, max_time, new_accumulator));
-            state.undo_move(state_eval.first, undo);
+    // Reverse futility pruning: a shallow node whose evaluation is above beta by more than a margin per ply
+    // is not expected to come back below it. Not done for mate scores, where the evaluation says nothing.
+    if (!pv_node && !node_in_check && rfp_enabled && depth <= rfp_depth
+        && static_eval - rfp_margin * depth >= beta && beta < search::mate_bound && beta > -search::mate_bound) {
+        return static_eval;
+    }
 
-            if(value >= beta) {
-                break;
-            }
-            
-            alpha = std::max(alpha, value);
+    // Razoring: a shallow node far below alpha only has captures left to catch up, check with quiescence search
+    if (!pv_node && !node_in_check && razoring_enabled && depth <= razoring_depth
+        && static_eval + razoring_margin * depth <= alpha && alpha > -search::mate_bound) {
+        search::score_t razor_value = alpha_beta_quiescence<search::node_type::non_pv>(context, 0, ply, alpha, beta, accumulator);
 
-            elapsed_time = std::chrono::steady_clock::now() - start_time;
+        if (razor_value <= alpha) {
+            return razor_value;
         }
     }
-    else {
-        sort(state_evals.begin(), state_evals.end(), sort_ascending);
 
-        value = std::numeric_limits<double>::infinity();
+    // Null move pruning: if passing the turn still fails high, a real move most likely will too.
+    // Zugzwang makes this unsound in check, in pawn endings and with little material, and it is never done twice in a row.
+    // A node whose static evaluation is below beta is unlikely to fail high even after passing, so it is not tried there.
+    if (allow_null && !pv_node && !node_in_check && depth >= null_move_min_depth && beta < search::mate_bound && static_eval >= beta
+        && search::non_pawn_material(state.get_board(), state.get_turn()) >= null_move_min_material) {
+
+        int reduction = null_move_reduction + depth / 4;
+
+        thread.stats.null_tries++;
+        // The child gets a position of its own, so the node's position needs no undo
+        search::thread_data::stack_entry& entry = thread.stack[ply];
+        search::make_null_move(state, entry.null_position);
+        search::search_context null_context{thread, entry.null_position, context.info, context.stop};
+
+        thread.history.push_null(entry.null_position.hash());
+        thread.current_line[ply] = chess::move();
+        // No piece moves, so the accumulators are passed on untouched
+        search::score_t null_value = -alpha_beta<search::node_type::non_pv>(null_context, depth - 1 - reduction, ply + 1, -beta, -beta + null_window, false, accumulator);
+        thread.history.pop();
+
+        if (null_value >= beta && !time_is_up(context)) {
+            thread.stats.null_cutoffs++;
+            // Do not trust mate scores from a position that can not occur
+            return null_value >= search::mate_bound ? beta : null_value;
+        }
+    }
 
-        elapsed_time = std::chrono::steady_clock::now() - start_time;
+    // Moves are produced stage by stage, a cutoff by the table move or a capture saves the rest of the work
+    search::move_picker picker(state, table_move, ply, thread.current_line[ply - 1], thread.order, thread.picker_stats, thread.stack[ply].picker);
 
-        for(size_t i = 0; i < state_evals.size() && (!stop && elapsed_time.count() < max_time); i++) {
-            auto state_eval = state_evals[i]; 
+    search::score_t value = -inf;
+    chess::move best_move = chess::move();
+    search::move_list<chess::move>& quiets_tried = thread.stack[ply].quiets_tried;
+    quiets_tried.clear();
+
+    chess::move move;
+
+    for(int i = 0; picker.next(move); i++) {
+        bool quiet = !picker.is_capture(move);
+        bool bad_capture = picker.is_bad_capture();
+
+        // Futility pruning and late move pruning skip quiet moves near the horizon once a move has been searched:
+        // those that can not raise a low evaluation to alpha, and those that come late in the order.
+        // Checking moves are kept, they can change the evaluation by more than any margin.
+        if (!pv_node && quiet && !node_in_check && value > -search::mate_bound
+            && ((futility_enabled && depth <= futility_depth && static_eval + futility_margin * depth <= alpha)
+                || (lmp_enabled && depth <= lmp_depth && i >= lmp_base + depth * depth))
+            && !search::gives_check(state, move)) {
+            continue;
+        }
 
-            NNUE::accumulator new_accumulator(accumulator);
-            set_accumulator(new_accumulator, state_eval.first, state);
+        thread.current_line[ply] = move;
 
-            chess::undo undo = state.make_move(state_eval.first);
+        // A child searched with a null window keeps no line of its own, so one from an earlier sibling must not be picked up
+        if constexpr (pv_node) {
+            thread.pv_length[ply + 1] = ply + 1;
+        }
 
-            value = std::min(value, alpha_beta(state, own_side, depth + 1, max_depth, max_depth_quiescence, alpha, beta, true, states_evaluated, 
-                        prev_evaluated, info, stop, start_time, max_time, new_accumulator));
-            state.undo_move(state_eval.first, undo);
+        NNUE::accumulator& new_accumulator = accumulators[thread.id][ply + 1];
+        new_accumulator = accumulator;
+        set_accumulator(new_accumulator, move, state);
 
-            if(value <= alpha) {
-                break;
+        chess::undo undo = state.make_move(move);
+        thread.history.push(state.hash(), state.get_halfmove_clock());
+
+        search::score_t child_value;
+
+        // The first move is assumed best, the rest only have to be proven worse
+        if(i == 0) {
+            child_value = -alpha_beta<type>(context, depth - 1, ply + 1, -beta, -alpha, true, new_accumulator);
+        }
+        else {
+            // Late quiet moves are unlikely to be best and are searched shallower, captures that lose material by SEE even more so.
+            // Other captures, check evasions and checking moves are searched to full depth.
+            int reduction = 0;
+
+            if (lmr_enabled && depth >= lmr_min_depth && i >= lmr_min_moves && (quiet || bad_capture) && !node_in_check
+                && !thread.order.is_killer(ply, move) && !search::in_check(state)) {
+                // Never below 0, a negative reduction would extend late moves at depth 1
+                reduction = std::max(0, std::min(reductions.get(depth, i + 1) + (bad_capture ? 1 : 0), depth - 2));
+            }
+
+            child_value = -alpha_beta<search::node_type::non_pv>(context, depth - 1 - reduction, ply + 1, -alpha - null_window, -alpha, true, new_accumulator);
+
+            if(reduction > 0) {
+                thread.stats.lmr_tries++;
+                thread.stats.lmr_successes += child_value <= alpha;
+            }
+
+            // Reduced move beat alpha, verify at full depth
+            if(reduction > 0 && child_value > alpha) {
+                child_value = -alpha_beta<search::node_type::non_pv>(context, depth - 1, ply + 1, -alpha - null_window, -alpha, true, new_accumulator);
+            }
+
+            // Only a PV node has a wider window to re-search with, a null window node is done once the move fails high
+            if constexpr (pv_node) {
+                if(child_value > alpha && child_value < beta) {
+                    child_value = -alpha_beta<search::node_type::pv>(context, depth - 1, ply + 1, -beta, -alpha, true, new_accumulator);
+                }
+            }
+        }
+
+        thread.history.pop();
+        state.undo_move(move, undo);
+
+        if(child_value > value) {
+            value = child_value;
+            best_move = move;
+        }
+
+        if(value > alpha) {
+            alpha = value;
+
+            if constexpr (pv_node) {
+                thread.update_pv(ply, move);
+            }
+        }
+
+        if(alpha >= beta) {
+            thread.stats.fail_highs++;
+            thread.stats.first_move_fail_highs += i == 0;
+            thread.stats.cutoff_index_sum += i;
+
+            // Remember quiet moves that refute the previous move
+            if(quiet && !time_is_up(context)) {
+                thread.order.update(state.get_turn(), move, depth, ply, thread.current_line[ply - 1], quiets_tried);
             }
+            break;
+        }
 
-            beta = std::min(beta, value);
+        if(time_is_up(context)) {
+            break;
+        }
 
-            elapsed_time = std::chrono::steady_clock::now() - start_time;
+        if(quiet) {
+            quiets_tried.push_back(move);
         }
     }
 
-    states_evaluated[pos_hash] = value;
+    // Checkmate and stalemate are found here, from having no legal move, so a node generates its moves at most once.
+    // The score is exact at any depth.
+    if (value == -inf) {
+        value = node_in_check ? search::mated_in(ply) : 0;
+        table_store(state, search::max_ply, ply, -inf, inf, value, chess::move());
+        return value;
+    }
+
+    if (!time_is_up(context)) {
+        table_store(state, depth, ply, alpha_orig, beta, value, best_move);
+    }
 
     return value;
 }
 
-double alpha_beta_engine::alpha_beta_quiescence(chess::position& state, chess::side own_side, int depth, int max_depth_quiescence, double alpha, double beta, bool max_player,
-						double* states_evaluated, double* prev_evaluated, uci::search_info& info,
-						const std::atomic_bool& stop, const std::chrono::steady_clock::time_point& start_time, const float max_time,
-						const NNUE::accumulator& accumulator) {    
 
-    size_t pos_hash = state.hash() & key_mask;
+/**
+ * Searches captures and queen promotions until the position is quiet, so that the evaluation is never taken in the middle of an exchange.
+ * The side to move may stand pat on the static evaluation, except in check where all evasions are searched.
+ */
+template<search::node_type type>
+search::score_t alpha_beta_engine::alpha_beta_quiescence(search::search_context& context, int depth, int ply, search::score_t alpha, search::score_t beta,
+						const NNUE::accumulator& accumulator) {
+
+    constexpr bool pv_node = type == search::node_type::pv;
+    search::thread_data& thread = context.thread;
+    chess::position& state = context.state;
 
+    thread.count_node();
+    thread.stats.qnodes++;
+    thread.seldepth = std::max(thread.seldepth, ply);
+
+    if constexpr (pv_node) {
+        thread.pv_length[ply] = ply;
+    }
 
-    if(depth >= max_depth_quiescence || is_stable(state) || is_terminal(state)) {
-        double eval = evaluate(accumulator, own_side);
-        states_evaluated[pos_hash] = eval;
-        return eval;
+    if(depth >= max_quiescence_depth || ply >= search::max_ply - 1 || time_is_up(context)) {
+        return evaluate(state, accumulator);
     }
 
-    auto current_time = std::chrono::steady_clock::now();
-    std::chrono::duration<double> elapsed_time = current_time - start_time;
+    bool node_in_check = search::in_check(state);
+    search::score_t stand_pat = -inf;
+    search::score_t value = -inf;
 
-    if (stop || elapsed_time.count() > max_time) {
-        double eval = evaluate(accumulator, own_side);
-        states_evaluated[pos_hash] = eval;
-        return eval;
+    if(!node_in_check) {
+        stand_pat = evaluate(state, accumulator);
+
+        if(stand_pat >= beta) {
+            return stand_pat;
+        }
+
+        value = stand_pat;
+        alpha = std::max(alpha, stand_pat);
     }
 
-    std::vector<std::pair<chess::move, double>> state_evals;
-    child_state_evals(state, own_side, prev_evaluated, true, state_evals, accumulator);
+    // In check every legal move is searched, otherwise only captures and queen promotions are generated
+    search::move_picker picker = node_in_check
+        ? search::move_picker(state, chess::move(), ply, thread.current_line[ply - 1], thread.order, thread.picker_stats, thread.stack[ply].picker)
+        : search::move_picker(state, thread.current_line[ply - 1], thread.order, thread.picker_stats, thread.stack[ply].picker);
+
+    chess::move move;
 
-    double value;
+    while(picker.next(move)) {
+        // Captures that lose material by SEE come last and are not worth searching
+        if(!node_in_check && picker.is_bad_capture()) {
+            break;
+        }
+
+        // Delta pruning: skip captures that can not bring the score up to alpha even with a margin
+        if(!node_in_check && move.promote == chess::piece_none
+            && stand_pat + search::piece_value(search::captured_piece(state.get_board(), move)) + delta_margin <= alpha) {
+            continue;
+        }
 
-    if(max_player) {
-        sort(state_evals.begin(), state_evals.end(), sort_descending);
+        thread.current_line[ply] = move;
 
-        value = -std::numeric_limits<double>::infinity();
+        NNUE::accumulator& new_accumulator = accumulators[thread.id][ply + 1];
+        new_accumulator = accumulator;
+        set_accumulator(new_accumulator, move, state);
 
-        elapsed_time = std::chrono::steady_clock::now() - start_time;
+        chess::undo undo = state.make_move(move);
+        search::score_t child_value = -alpha_beta_quiescence<type>(context, depth + 1, ply + 1, -beta, -alpha, new_accumulator);
+        state.undo_move(move, undo);
 
-        for(size_t i = 0; i < state_evals.size() && (!stop && elapsed_time.count() < max_time); i++) {
-            auto state_eval = state_evals[i]; 
+        value = std::max(value, child_value);
 
-            NNUE::accumulator new_accumulator(accumulator);
-            set_accumulator(new_accumulator, state_eval.first, state);
-            chess::undo undo = state.make_move(state_eval.first);
-            
-            value = std::max(value, alpha_beta_quiescence(state, own_side, depth + 1, max_depth_quiescence, alpha, beta, false, states_evaluated, 
-                            prev_evaluated, info, stop, start_time, max_time, new_accumulator));
-            state.undo_move(state_eval.first, undo);
+        if(value > alpha) {
+            alpha = value;
 
-            if(value >= beta) {
-                break;
+            if constexpr (pv_node) {
+                thread.update_pv(ply, move);
             }
-            
-            alpha = std::max(alpha, value);
+        }
 
-            elapsed_time = std::chrono::steady_clock::now() - start_time;
+        if(alpha >= beta || time_is_up(context)) {
+            break;
         }
     }
-    else {
-        sort(state_evals.begin(), state_evals.end(), sort_ascending);
 
-        value = std::numeric_limits<double>::infinity();
 
-        elapsed_time = std::chrono::steady_clock::now() - start_time;
+    // In check without an evasion
+    if(node_in_check && value == -inf) {
+        return search::mated_in(ply);
+    }
 
-        for(size_t i = 0; i < state_evals.size() && (!stop && elapsed_time.count() < max_time); i++) {
-            auto state_eval = state_evals[i]; 
+    return value;
+}
 
-            NNUE::accumulator new_accumulator(accumulator);
-            set_accumulator(new_accumulator, state_eval.first, state);
-            chess::undo undo = state.make_move(state_eval.first);
-            
-            value = std::min(value, alpha_beta_quiescence(state, own_side, depth + 1, max_depth_quiescence, alpha, beta, true, states_evaluated, 
-                        prev_evaluated, info, stop, start_time, max_time, new_accumulator));
-            state.undo_move(state_eval.first, undo);
 
-            if(value <= alpha) {
-                break;
-            }
+/**
+ * Looks up the position in the transposition table. The best move stored is always returned through table_move,
+ * and true is returned if the stored score is deep enough to be used as the value of the position.
+ */
+bool alpha_beta_engine::table_probe(search::search_stats& stats, const chess::position& state, int depth, int ply, search::score_t alpha, search::score_t beta, search::score_t& value, chess::move& table_move) {
 
-            beta = std::min(beta, value);
+    search::tt_entry entry;
+    stats.tt_probes++;
 
-            elapsed_time = std::chrono::steady_clock::now() - start_time;
-        }
+    if(!table.probe(state.hash(), entry)) {
+        return false;
     }
 
-    states_evaluated[pos_hash] = value;
+    stats.tt_hits++;
 
-    return value;
+    table_move = search::unpack_move(entry.move);
+
+    if(entry.depth < depth) {
+        return false;
+    }
+
+    search::score_t score = search::score_from_table(entry.score, ply);
+
+    if(entry.type == search::bound::exact || (entry.type == search::bound::lower && score >= beta) || (entry.type == search::bound::upper && score <= alpha)) {
+        value = score;
+        return true;
+    }
+
+    return false;
+}
+
+
+/**
+ * Stores the value of a position searched with the window (alpha, beta).
+ */
+void alpha_beta_engine::table_store(const chess::position& state, int depth, int ply, search::score_t alpha, search::score_t beta, search::score_t value, const chess::move& best_move) {
+
+    search::bound type = search::bound::exact;
+
+    if(value <= alpha) {
+        type = search::bound::upper;
+    }
+    else if(value >= beta) {
+        type = search::bound::lower;
+    }
+
+    table.store(state.hash(), depth, type, search::score_to_table(value, ply), best_move);
+}
+
+
+/**
+ * True if the search has to stop. Reading the clock is slow compared to a node, so only the main thread does it
+ * every few nodes, and the other threads see the result.
+ */
+bool alpha_beta_engine::time_is_up(const search::search_context& context) {
+    if(context.thread.id == 0) {
+        // While pondering the clock that runs is the opponent's
+        if(!*pondering) {
+            timer.poll(context.thread.nodes.load(std::memory_order_relaxed));
+        }
+
+        // Fixed work searches stop at the node limit exactly
+        if(node_limit > 0 && searched_nodes() >= node_limit) {
+            limit_reached = true;
+        }
+    }
+
+    return context.stop || timer.expired() || limit_reached;
 }
 
-bool alpha_beta_engine::is_terminal(const chess::position& state) {
-    return state.is_checkmate() || state.is_stalemate();
+
+/**
+ * Move from the opening book for the root, if there is one. Searches that have to run until stopped,
+ * and searches restricted to some root moves, are left to the search.
+ */
+std::optional<chess::move> alpha_beta_engine::book_move(const uci::search_limit& limit, bool ponder, uci::search_info& info) {
+    std::string path = opt.get<uci::option_string>("Book File");
+
+    // The book stays mapped from move to move, it is only reopened when the option changes
+    if(path != book_path) {
+        book_path = path;
+        book.close();
+
+        if(!path.empty()) {
+            if(std::optional<std::string> error = book.open(path)) {
+                info.message(*error);
+            }
+        }
+    }
+
+    if(!book.is_open() || limit.infinite || ponder || !limit.moves.empty()) {
+        return std::nullopt;
+    }
+
+    return book.probe(root, opt.get<uci::option_check>("Book Best Move"), book_random);
 }
 
 
 /**
- * Returns true if there are no takes or promotes are possible from the given state
+ * The second move of the best line is the reply the search expects. A line cut short by a table cutoff is continued
+ * with the table move of the position after the best move, if it is legal there.
  */
-bool alpha_beta_engine::is_stable(const chess::position& state) {
-    for(chess::move move : state.moves()) {
-        if(!is_quiet(state, move))
-            return false;
+std::optional<chess::move> alpha_beta_engine::ponder_move(search::search_stats& stats, const chess::move& best_move, const std::vector<chess::move>& line) {
+    if (line.size() >= 2) {
+        return line[1];
+    }
+
+    if (search::pack_move(best_move) == 0) {
+        return std::nullopt;
+    }
+
+    chess::position state = root;
+    state.make_move(best_move);
+
+    search::score_t table_value;
+    chess::move table_move;
+    table_probe(stats, state, 0, 1, -inf, inf, table_value, table_move);
+
+    if (search::pack_move(table_move) != 0 && search::is_legal(state, table_move)) {
+        return table_move;
     }
 
-    return true;
+    return std::nullopt;
 }
 
 
 /**
- * Returns true if move is not a take or promotion
+ * Sends one line of a finished iteration.
  */
-bool alpha_beta_engine::is_quiet(const chess::position& state, const chess::move& move) {
-    chess::square sq = move.to;
-    chess::piece promote = move.promote;
+void alpha_beta_engine::report_iteration(const search::thread_data& thread, int depth, int multipv, search::score_t score, const std::vector<chess::move>& line, uci::search_info& info) {
+    std::optional<int> mate;
 
-    return state.get_board().get(sq).second == chess::piece_none && promote == chess::piece_none;
+    if (search::is_mate(score)) {
+        mate = search::mate_moves(score);
+    }
+
+    info.iteration(depth, std::max(depth, thread.seldepth), multipv, score, mate, searched_nodes(), table.hashfull(), line);
+}
+
+
+unsigned long long alpha_beta_engine::search_allocations() const {
+    unsigned long long total = 0;
+
+    for(const auto& thread: threads) {
+        total += thread->tree_allocations;
+    }
+
+    return total;
 }
 
 
-bool sort_ascending(const std::pair<chess::move, double>& p1, const std::pair<chess::move, double>& p2) {
-   return p1.second < p2.second;
+unsigned long long alpha_beta_engine::searched_nodes() const {
+    unsigned long long total = 0;
+
+    for(const auto& thread: threads) {
+        total += thread->nodes.load(std::memory_order_relaxed);
+    }
+
+    return total;
 }
 
+
 bool sort_descending(const std::pair<chess::move, double>& p1, const std::pair<chess::move, double>& p2) {
    return p1.second > p2.second;
 }
@@ -425,11 +1062,17 @@ bool sort_descending(const std::pair<chess::move, double>& p1, const std::pair<c
 // pawn, rook, knight, bishop, queen, king
 const double value_map[6] = {1.0, 5.0, 3.0, 3.0, 9.0, 0.0};
 
-double alpha_beta_engine::evaluate(const NNUE::accumulator& accumulator, chess::side own_side) {
-    
-    double eval = evaluator.forward(accumulator.accumulator_white, accumulator.accumulator_black, own_side);
+search::score_t alpha_beta_engine::evaluate(const chess::position& state, const NNUE::accumulator& accumulator) {
+
+    // Basic endings are known exactly, and looking them up is cheaper than running the network
+    if(std::optional<search::score_t> value = search::evaluate_endgame(state)) {
+        return *value;
+    }
+
+    float eval = evaluator.forward(accumulator.accumulator_white, accumulator.accumulator_black, state.get_turn());
     
-    return eval;
+    // The network output is in centipawns, it must never be mistaken for a mate
+    return std::clamp(static_cast<search::score_t>(std::lround(eval)), -search::mate_bound + 1, search::mate_bound - 1);
 }
 
 
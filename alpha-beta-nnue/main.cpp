@@ -6,6 +6,7 @@
 #include <torch/torch.h>
 #include <chess/chess.hpp>
 #include <uci/uci.hpp>
+#include <search/bench.hpp>
 
 #include "engine.hpp"
 
@@ -23,6 +24,34 @@ int main(int argc, char** argv)
 
 	chess::init();
 	alpha_beta_engine engine;
+
+	// `<engine> bench [depth]` searches a fixed set of positions and reports node counts
+	if(argc > 1 && std::string(argv[1]) == "bench")
+	{
+		int depth = argc > 2 ? std::stoi(argv[2]) : 5;
+		return search::bench(engine, depth);
+	}
+
+	// `<engine> smp [depth]` reports time to depth with 1 to 16 threads
+	if(argc > 1 && std::string(argv[1]) == "smp")
+	{
+		int depth = argc > 2 ? std::stoi(argv[2]) : 8;
+		return search::smp_bench(engine, depth);
+	}
+
+	// `<engine> pruning [depth]` reports the nodes each kind of forward pruning saves
+	if(argc > 1 && std::string(argv[1]) == "pruning")
+	{
+		int depth = argc > 2 ? std::stoi(argv[2]) : 7;
+		return search::pruning_bench(engine, depth);
+	}
+
+	// `<engine> see [iterations]` times static exchange evaluation
+	if(argc > 1 && std::string(argv[1]) == "see")
+	{
+		int iterations = argc > 2 ? std::stoi(argv[2]) : 100000;
+		return search::see_bench(iterations);
+	}
 	
 	return uci::main(engine);
 }
@@ -3,27 +3,25 @@
 
 #include <chess/chess.hpp>
 
-#include <limits>
+#include <search/score.hpp>
 
 namespace new_eval {
 
 
 /* Constants */
 
-const double MATERIAL_MAX = 3900;
+const int MATERIAL_MAX = 3900;
 
 const int END_GAME_LIMIT = 1000;
 
-const double INF_DOUBLE = std::numeric_limits<double>::infinity();
-
-const double MATERIAL_VALUE_MAP[5] = {
+const int MATERIAL_VALUE_MAP[5] = {
     100, // pawn
     500, // rook
     300, // knight
     300, // bishop
     900  // queen
 };
-const double POSITION_VALUE_MAP[7][64] = {
+const int POSITION_VALUE_MAP[7][64] = {
     {   // Pawns
         0,  0,  0,  0,  0,  0,  0,  0,
         50, 50, 50, 50, 50, 50, 50, 50,
@@ -99,20 +97,15 @@ const double POSITION_VALUE_MAP[7][64] = {
 
 /* Functions */
 
-inline double evaluate(const chess::position& pos, chess::side own_side) {
-    if (pos.is_checkmate()) {
-        return pos.get_turn() == own_side ? -INF_DOUBLE : INF_DOUBLE; 
-    } else if (pos.is_stalemate()) {
-        return 0.0;
-    }
-
+// Static evaluation only, checkmate and stalemate are detected by the search when a node has no legal move.
+inline search::score_t evaluate(const chess::position& pos, chess::side own_side) {
     const chess::board& b = pos.get_board();
 
-    double position_value_own = 0.0;
-    double position_value_opponent = 0.0;
+    int position_value_own = 0;
+    int position_value_opponent = 0;
 
-    double material_value_own = 0.0;
-    double material_value_opponent = 0.0;
+    int material_value_own = 0;
+    int material_value_opponent = 0;
 
     chess::square king_sq_own = chess::square_none;
     chess::square king_sq_opponent = chess::square_none;
@@ -144,10 +137,10 @@ inline double evaluate(const chess::position& pos, chess::side own_side) {
                 y = 7 - y; // chess::ranks - 1 = 7
             }
 
-            double position_value = POSITION_VALUE_MAP[piece][y*chess::ranks + x];
+            int position_value = POSITION_VALUE_MAP[piece][y*chess::ranks + x];
 
             /* Material value */
-            double material_value = MATERIAL_VALUE_MAP[piece];
+            int material_value = MATERIAL_VALUE_MAP[piece];
 
             if (side == own_side) {
                 position_value_own += position_value;
@@ -181,11 +174,11 @@ inline double evaluate(const chess::position& pos, chess::side own_side) {
     position_value_opponent += POSITION_VALUE_MAP[king_pos_map_piece_index_opponent][y_king_opponent*chess::ranks + x_king_opponent];
     
     /* Normalize and combine material and position values */
-    position_value_own = (material_value_own / MATERIAL_MAX) * position_value_own;
-    double value_own = position_value_own + material_value_own;
+    position_value_own = material_value_own * position_value_own / MATERIAL_MAX;
+    int value_own = position_value_own + material_value_own;
 
-    position_value_opponent = (material_value_opponent / MATERIAL_MAX) * position_value_opponent;
-    double value_opponent = position_value_opponent + material_value_opponent;
+    position_value_opponent = material_value_opponent * position_value_opponent / MATERIAL_MAX;
+    int value_opponent = position_value_opponent + material_value_opponent;
     
     return value_own - value_opponent;
 }
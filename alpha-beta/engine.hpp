@@ -1,11 +1,26 @@
 #include <random>
+#include <optional>
 #include <vector>
 #include <atomic>
 #include <chrono>
 #include <utility>
+#include <array>
+#include <memory>
 
 #include <chess/chess.hpp>
 #include <uci/uci.hpp>
+#include <search/score.hpp>
+#include <search/transposition_table.hpp>
+#include <search/reductions.hpp>
+#include <search/move_order.hpp>
+#include <search/move_picker.hpp>
+#include <search/thread_data.hpp>
+#include <search/hash_history.hpp>
+#include <search/search_context.hpp>
+#include <search/time_manager.hpp>
+#include <search/book.hpp>
+#include <search/tablebase.hpp>
+#include <search/endgame.hpp>
 
 
 class alpha_beta_engine: public uci::engine
@@ -24,45 +39,131 @@ public:
 		return "CEO of CashMoney Inc";
 	}
 
-	static constexpr int key_size = 24;
-	static constexpr int table_size = 1 << 24;
-	static constexpr int key_mask = (1 << 24) - 1;
-
     void setup(const chess::position& position, const std::vector<chess::move>& moves) override;
     uci::search_result search(const uci::search_limit& limit, uci::search_info& info, const std::atomic_bool& ponder, const std::atomic_bool& stop) override; //Main function
     void reset() override;
 
-	chess::move alpha_beta_search(chess::position state, int max_depth, double* states_evaluated, double* prev_evaluated,
-									uci::search_info& info, const std::atomic_bool& stop, const std::chrono::steady_clock::time_point& start_time, 
-									const float max_time);
-	
-	double alpha_beta(chess::position& state, chess::side own_side, int depth, int max_depth, int max_depth_quiescence, double alpha, double beta, bool max_player,
-						double* states_evaluated, double* prev_evaluated, uci::search_info& info,
-						const std::atomic_bool& stop, const std::chrono::steady_clock::time_point& start_time, const float max_time);
+	uci::search_result iterative_deepening(search::thread_data& thread, const uci::search_limit& limit, uci::search_info& info,
+									const std::atomic_bool& stop);
+
+	search::score_t alpha_beta_search(search::search_context& context, int depth, search::score_t alpha, search::score_t beta, chess::move& best_move,
+									const std::vector<chess::move>& excluded);
 
+	template<search::node_type type>
+	search::score_t alpha_beta(search::search_context& context, int depth, int ply, search::score_t alpha, search::score_t beta, bool allow_null);
 
-	double alpha_beta_quiescence(chess::position& state, chess::side own_side, int depth, int max_depth_quiescence, double alpha, double beta, bool max_player,
-						double* states_evaluated, double* prev_evaluated, uci::search_info& info,
-						const std::atomic_bool& stop, const std::chrono::steady_clock::time_point& start_time, const float max_time);
+	template<search::node_type type>
+	search::score_t alpha_beta_quiescence(search::search_context& context, int depth, int ply, search::score_t alpha, search::score_t beta);
 
-	void child_state_evals(chess::position& state, chess::side own_side, double* prev_evaluated, bool quiescence_search,
-							std::vector<std::pair<chess::move, double>>& output);
+	// Nodes visited by the last search.
+	unsigned long long searched_nodes() const;
+
+	// Heap allocations of the last search below the root, counted in debug builds only.
+	unsigned long long search_allocations() const;
 
 
 
 private:
 	chess::position root;
 
-    static constexpr double inf = std::numeric_limits<double>::infinity();
+	// Positions of the game up to the root that the search can still repeat.
+	search::hash_history game_history;
+	search::transposition_table table;
+
+	// Search threads, the first one is the main thread.
+	std::vector<std::unique_ptr<search::thread_data>> threads;
+
+	static constexpr int max_threads = 256;
+
+	search::time_manager timer;
+
+	// Root moves allowed by go searchmoves, empty for all moves.
+	std::vector<chess::move> search_moves;
+
+	// Opening book of the Book File option, reopened when it changes.
+	search::opening_book book;
+	std::string book_path;
+	std::mt19937 book_random;
+
+	// Syzygy tables of the SyzygyPath option, loaded again when it changes, and the most pieces probed in the search.
+	std::string syzygy_path;
+	int tablebase_limit;
+
+	// Node budget of go nodes, 0 for none, and whether it has been used up.
+	unsigned long long node_limit;
+	std::atomic_bool limit_reached;
+
+	// Ponder flag of the current search. Time limits are ignored while it is set.
+	const std::atomic_bool* pondering;
+
+	// Number of best lines the main thread searches, from the MultiPV option and the number of root moves.
+	int multi_pv;
+
+	// Most legal moves in any position.
+	static constexpr int max_multi_pv = 218;
+
+	// Nodes of the main thread between two readings of the clock.
+	static constexpr unsigned long long time_poll_nodes = 1024;
+
+	// Default of the Move Overhead option, in milliseconds.
+	static constexpr int default_move_overhead = 10;
+
+	static constexpr int default_hash_mb = 64;
+
+	// Half width of the first aspiration window around the previous score, in centipawns.
+	static constexpr search::score_t aspiration_window = 25;
+	static constexpr search::score_t max_aspiration_window = 1000;
+
+	// Width of the windows used to test if a move is better than the current best.
+	static constexpr search::score_t null_window = 1;
+
+	// Late move reductions, configured by the LMR options at the start of each search.
+	search::reduction_table reductions;
+	bool lmr_enabled;
+	int lmr_min_depth;
+	int lmr_min_moves;
+
+	// Forward pruning, configured by the pruning options at the start of each search. Each applies up to its depth,
+	// margins are in centipawns per ply of depth, and late move pruning keeps lmp_base + depth * depth moves.
+	bool rfp_enabled;
+	int rfp_depth;
+	search::score_t rfp_margin;
+	bool futility_enabled;
+	int futility_depth;
+	search::score_t futility_margin;
+	bool razoring_enabled;
+	int razoring_depth;
+	search::score_t razoring_margin;
+	bool lmp_enabled;
+	int lmp_depth;
+	int lmp_base;
+
+	// Null move pruning is tried from this depth, reducing the search by null_move_reduction + depth / 4 plies.
+	static constexpr int null_move_min_depth = 3;
+	static constexpr int null_move_reduction = 2;
+
+	// Side to move needs at least this much non-pawn material (centipawns) to try a null move.
+	static constexpr int null_move_min_material = 500;
+
+	// Quiescence search gives up this many plies past the horizon.
+	static constexpr int max_quiescence_depth = 8;
+
+	// Captures that can not raise the score to alpha even with this margin (centipawns) are not searched in quiescence.
+	static constexpr search::score_t delta_margin = 200;
+
+	bool table_probe(search::search_stats& stats, const chess::position& state, int depth, int ply, search::score_t alpha, search::score_t beta, search::score_t& value, chess::move& table_move);
+	void table_store(const chess::position& state, int depth, int ply, search::score_t alpha, search::score_t beta, search::score_t value, const chess::move& best_move);
+	bool time_is_up(const search::search_context& context);
+	std::optional<chess::move> ponder_move(search::search_stats& stats, const chess::move& best_move, const std::vector<chess::move>& line);
+	std::optional<chess::move> book_move(const uci::search_limit& limit, bool ponder, uci::search_info& info);
+	void report_iteration(const search::thread_data& thread, int depth, int multipv, search::score_t score, const std::vector<chess::move>& line, uci::search_info& info);
+
+    static constexpr search::score_t inf = search::infinite_value;
 
-	double evaluate(const chess::position& state, chess::side own_side);
+	search::score_t evaluate(const chess::position& state);
     double old_evaluate(const chess::position& state, chess::side own_side);
-    bool is_terminal(const chess::position& state);
-	bool is_stable(const chess::position& state);
-	bool is_quiet(const chess::position& state, const chess::move& move);
     	
 };
 
-bool sort_ascending(const std::pair<chess::move, double>& p1, const std::pair<chess::move, double>& p2);
 bool sort_descending(const std::pair<chess::move, double>& p1, const std::pair<chess::move, double>& p2);
 
@@ -69,35 +69,15 @@ uci::search_result engine::search(const uci::search_limit& limit, uci::search_in
 
 		// Set search datastructures
 		std::unordered_map<size_t, double> pos_scores;
-		best.clear();
 		
-		double val = minmax::rec_minmax(root, root, true, -inf, inf, 0, eval_depth, own_side, pos_scores, prev_scores, info, stop, start_time, max_time);
-
-		// Trace back and find the best line
-		chess::position curr = root;
-		chess::position p;
-		for (int i = 0; i < eval_depth; i++) {
-			bool found = false;
-			for (chess::move m : curr.moves()) {
-
-				p = root.copy_move(m);
-				size_t p_hash = p.hash();
-
-				if (pos_scores.count(p_hash) >= 1) {
-					if (pos_scores[p_hash] == val) {
-						best.push_back(m);
-						curr = p;
-
-						found = true;
-						break;
-					}
-				}
-			}
-
-			if (!found) {
-				break;
-			}
-
+		double val = minmax::rec_minmax(root, root, true, -inf, inf, 0, eval_depth, own_side, best, pos_scores, prev_scores, info, stop, start_time, max_time);
+
+		// Mate scores count the plies to the mate, table hits cut the line short so its length can not be used
+		if (minmax::is_mate(val)) {
+			int plies = minmax::mate_plies(val);
+			info.mate(val > 0 ? (plies + 1) / 2 : -(plies / 2));
+		} else {
+			info.score(val * 100);
 		}
 		info.line(best);
 
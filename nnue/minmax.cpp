@@ -1,7 +1,37 @@
+#include <cmath>
+
 #include "minmax.hpp"
 
 namespace minmax {
     const double value_map[] = {1.0, 5.0, 3.0, 3.0, 9.0, 0.0};
+
+    bool is_mate(double score)
+    {
+        return std::abs(score) >= mate_bound;
+    }
+
+    int mate_plies(double score)
+    {
+        return static_cast<int>(mate_value - std::abs(score));
+    }
+
+    // The tables keep mates counted from the position they belong to, so that a hit at another depth gets the right distance
+    double to_table(double score, int depth)
+    {
+        if (is_mate(score)) {
+            return score > 0 ? score + depth : score - depth;
+        }
+        return score;
+    }
+
+    double from_table(double score, int depth)
+    {
+        if (is_mate(score)) {
+            return score > 0 ? score - depth : score + depth;
+        }
+        return score;
+    }
+
     double estimate_score(const chess::position &p, const chess::side own_side) 
     {
 
@@ -28,25 +58,21 @@ namespace minmax {
     }
 
 
-    bool sort_pos_ascending(const std::pair<double, chess::position>& p1, const std::pair<double, chess::position>& p2)
+    bool sort_pos_ascending(const child& p1, const child& p2)
     {
-        return p1.first < p2.first;
+        return p1.score < p2.score;
     }
 
-    bool sort_pos_descending(const std::pair<double, chess::position>& p1, const std::pair<double, chess::position>& p2)
+    bool sort_pos_descending(const child& p1, const child& p2)
     {
-        return p1.first > p2.first;
+        return p1.score > p2.score;
     }
 
 
-    bool sort_move_descending(const std::pair<double, chess::move>& p1, const std::pair<double, chess::move>& p2) 
+    double rec_minmax(const chess::position& pos, const chess::position& root, bool max_node, double alpha, double beta, int curr_depth, int max_depth, const chess::side own_side, std::vector<chess::move>& line, std::unordered_map<size_t, double>& pos_scores, std::unordered_map<size_t, double>& prev_scores, uci::search_info& info, const std::atomic_bool& stop, const std::chrono::steady_clock::time_point& start_time, float max_time) 
     {
-        return p1.first > p2.first;
-    }
-
+        line.clear();
 
-    double rec_minmax(const chess::position& pos, const chess::position& root, bool max_node, double alpha, double beta, int curr_depth, int max_depth, const chess::side own_side, std::unordered_map<size_t, double>& pos_scores, std::unordered_map<size_t, double>& prev_scores, uci::search_info& info, const std::atomic_bool& stop, const std::chrono::steady_clock::time_point& start_time, float max_time) 
-    {
         size_t pos_hash = pos.hash();
         bool first_search = pos_hash == root.hash();
 
@@ -57,15 +83,14 @@ namespace minmax {
 
         if (pos_scores.count(pos_hash) >= 1) {             
             // Already in transposition table 
-            pos_val = pos_scores[pos_hash];
+            pos_val = from_table(pos_scores[pos_hash], curr_depth);
 
         } else if (pos.is_checkmate()) {
+            // The side to move is mated
             if (pos.get_turn() == own_side) {
-                info.mate(pos.fullmove() - root.fullmove());
-
-                pos_val = std::numeric_limits<double>::infinity();
+                pos_val = -(mate_value - curr_depth);
             } else {
-                pos_val = -std::numeric_limits<double>::infinity();
+                pos_val = mate_value - curr_depth;
             }
             
         } else if (pos.is_stalemate()) {
@@ -77,34 +102,26 @@ namespace minmax {
         } else if (stop || elapsed_time.count() > max_time) {
             // Stop search
             if (prev_scores.count(pos_hash) >= 1) {
-                pos_val = prev_scores[pos_hash];
+                pos_val = from_table(prev_scores[pos_hash], curr_depth);
             } else {
                 pos_val = estimate_score(pos, own_side);
             }
         } else {
 
-            std::vector<std::pair<double, chess::position>> n_pos_scores;
-            std::vector<std::pair<double, chess::move>> n_moves_scores;
-            int i = 0;
+            std::vector<child> n_pos_scores;
             for (chess::move m : pos.moves()) {
-                n_pos_scores.push_back(std::make_pair(0, pos.copy_move(m)));
+                chess::position next = pos.copy_move(m);
 
                 // Use estimate from previous search if there is any
-                size_t n_hash = std::get<1>(n_pos_scores[i]).hash();
-                if (prev_scores.count(n_hash) >= 1) {
-                    n_pos_scores[i].first = prev_scores[n_hash];
-                } else {
-                    n_pos_scores[i].first = estimate_score(std::get<1>(n_pos_scores[i]), own_side);
-                }
-                
+                size_t n_hash = next.hash();
+                double estimate = prev_scores.count(n_hash) >= 1 ? from_table(prev_scores[n_hash], curr_depth + 1) : estimate_score(next, own_side);
 
-                if (first_search) {
-                    n_moves_scores.push_back(std::make_pair(n_pos_scores[i].first, m));
-                }
-
-                i++;
+                n_pos_scores.push_back({estimate, next, m});
             }
 
+            // Best line of the child searched last, prefixed with its move when the child is the best so far
+            std::vector<chess::move> child_line;
+
 
             if (max_node) {
                 // MAX
@@ -112,20 +129,21 @@ namespace minmax {
                 // Sort elements in descending eval order
                 sort(n_pos_scores.begin(), n_pos_scores.end(), sort_pos_descending);
 
-                if (first_search) {
-                    sort(n_moves_scores.begin(), n_moves_scores.end(), sort_move_descending);
-                }
-
                 pos_val = -std::numeric_limits<double>::infinity();
 
                 int move_i = 0;
                 for (const auto& score_pos : n_pos_scores) {
 
                     if (first_search) {
-                        info.move(std::get<1>(n_moves_scores[move_i]), move_i);
+                        info.move(score_pos.move, move_i);
                     }
                     
-                    double child_val = rec_minmax(std::get<1>(score_pos), root, false, alpha, beta, curr_depth+1, max_depth, own_side, pos_scores, prev_scores, info, stop, start_time, max_time);
+                    double child_val = rec_minmax(score_pos.position, root, false, alpha, beta, curr_depth+1, max_depth, own_side, child_line, pos_scores, prev_scores, info, stop, start_time, max_time);
+
+                    if (child_val > pos_val || line.empty()) {
+                        line.assign(1, score_pos.move);
+                        line.insert(line.end(), child_line.begin(), child_line.end());
+                    }
 
                     pos_val = std::max(pos_val, child_val);
 
@@ -146,7 +164,12 @@ namespace minmax {
                 pos_val = std::numeric_limits<double>::infinity();
                 for (const auto& score_pos : n_pos_scores) {
                     
-                    double child_val = rec_minmax(std::get<1>(score_pos), root, true, alpha, beta, curr_depth+1, max_depth, own_side, pos_scores, prev_scores, info, stop, start_time, max_time);
+                    double child_val = rec_minmax(score_pos.position, root, true, alpha, beta, curr_depth+1, max_depth, own_side, child_line, pos_scores, prev_scores, info, stop, start_time, max_time);
+
+                    if (child_val < pos_val || line.empty()) {
+                        line.assign(1, score_pos.move);
+                        line.insert(line.end(), child_line.begin(), child_line.end());
+                    }
 
                     pos_val = std::min(pos_val, child_val);
 
@@ -159,7 +182,7 @@ namespace minmax {
             }
         }
 
-        pos_scores[pos_hash] = pos_val;
+        pos_scores[pos_hash] = to_table(pos_val, curr_depth);
 
         return pos_val;
     }
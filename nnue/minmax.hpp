@@ -2,6 +2,7 @@
 #define MINMAX_H
 
 #include <utility>
+#include <vector>
 #include <chrono>
 
 #include <chess/chess.hpp>
@@ -9,14 +10,30 @@
 
 namespace minmax {
 
-    double estimate_score(const chess::position &p, const chess::side own_side);
+    // Position reached by a move, with the estimate used to order it.
+    struct child {
+        double score;
+        chess::position position;
+        chess::move move;
+    };
+
+    // A mate is scored mate_value minus its distance from the root in plies, so that the distance can be read back
+    // from the score. Every score beyond mate_bound is a mate.
+    constexpr double mate_value = 1000000;
+    constexpr double mate_bound = mate_value - 1000;
+
+    bool is_mate(double score);
 
-    bool sort_pos_ascending(const std::pair<double, chess::position>& p1, const std::pair<double, chess::position>& p2);
-    bool sort_pos_descending(const std::pair<double, chess::position>& p1, const std::pair<double, chess::position>& p2);
+    // Plies from the root to the mate of a mate score.
+    int mate_plies(double score);
+
+    double estimate_score(const chess::position &p, const chess::side own_side);
 
-    bool sort_move_descending(const std::pair<double, chess::move>& p1, const std::pair<double, chess::move>& p2);
+    bool sort_pos_ascending(const child& p1, const child& p2);
+    bool sort_pos_descending(const child& p1, const child& p2);
 
-    double rec_minmax(const chess::position& pos, const chess::position& root, bool max_node, double alpha, double beta, int curr_depth, int max_depth, const chess::side own_side, std::unordered_map<size_t, double>& pos_scores, std::unordered_map<size_t, double>& prev_scores, uci::search_info& info, const std::atomic_bool& stop, const std::chrono::steady_clock::time_point& start_time, float max_time);
+    // The best line from pos is returned through line.
+    double rec_minmax(const chess::position& pos, const chess::position& root, bool max_node, double alpha, double beta, int curr_depth, int max_depth, const chess::side own_side, std::vector<chess::move>& line, std::unordered_map<size_t, double>& pos_scores, std::unordered_map<size_t, double>& prev_scores, uci::search_info& info, const std::atomic_bool& stop, const std::chrono::steady_clock::time_point& start_time, float max_time);
 }
 
 #endif /* MINMAX_H */
@@ -0,0 +1,74 @@
+#include <cstdlib>
+#include <new>
+
+#include "allocations.hpp"
+
+
+namespace
+{
+
+// per thread, so that a search thread's count is not disturbed by the others
+thread_local unsigned long long allocations = 0;
+
+}
+
+
+namespace search
+{
+
+
+unsigned long long allocation_count()
+{
+    return allocations;
+}
+
+
+}
+
+
+#if !defined(NDEBUG) || defined(SEARCH_DIAGNOSTICS)
+
+// replacing the global operators counts every allocation of the program, including those inside libraries
+void* operator new(std::size_t size)
+{
+    allocations++;
+
+    if(void* pointer = std::malloc(size == 0 ? 1 : size))
+    {
+        return pointer;
+    }
+
+    throw std::bad_alloc();
+}
+
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+
+void operator delete(void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+
+void operator delete[](void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+
+void operator delete[](void* pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef ALLOCATIONS_HPP
+#define ALLOCATIONS_HPP
+
+
+namespace search
+{
+
+
+// Heap allocations made by the calling thread so far. Counted in debug builds and with the search_diagnostics meson option,
+// always 0 otherwise.
+unsigned long long allocation_count();
+
+
+}
+
+
+#endif
@@ -0,0 +1,174 @@
+#include <array>
+#include <bit>
+#include <cstdint>
+
+#include "attack.hpp"
+
+
+namespace search
+{
+
+
+namespace
+{
+
+using table = std::array<chess::bitboard, 64>;
+
+// Set of squares reached by single steps (dx, dy) from each square.
+template<std::size_t N>
+table step_table(const std::array<std::pair<int, int>, N>& steps)
+{
+    table result{};
+
+    for(int sq = 0; sq < 64; sq++)
+    {
+        int x = sq % 8;
+        int y = sq / 8;
+
+        for(auto [dx, dy]: steps)
+        {
+            if(x + dx >= 0 && x + dx < 8 && y + dy >= 0 && y + dy < 8)
+            {
+                result[sq] |= chess::bitboard{1} << ((y + dy) * 8 + x + dx);
+            }
+        }
+    }
+
+    return result;
+}
+
+const table knight_table = step_table<8>({{{1, 2}, {2, 1}, {2, -1}, {1, -2}, {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2}}});
+const table king_table = step_table<8>({{{1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}, {0, -1}, {1, -1}}});
+const table white_pawn_table = step_table<2>({{{-1, 1}, {1, 1}}});
+const table black_pawn_table = step_table<2>({{{-1, -1}, {1, -1}}});
+
+chess::bitboard slide(chess::square square, chess::bitboard occupied, const std::array<std::pair<int, int>, 4>& directions)
+{
+    chess::bitboard result = 0;
+
+    for(auto [dx, dy]: directions)
+    {
+        int x = square % 8 + dx;
+        int y = square / 8 + dy;
+
+        while(x >= 0 && x < 8 && y >= 0 && y < 8)
+        {
+            chess::bitboard bit = chess::bitboard{1} << (y * 8 + x);
+            result |= bit;
+
+            if(occupied & bit)
+            {
+                break;
+            }
+
+            x += dx;
+            y += dy;
+        }
+    }
+
+    return result;
+}
+
+}
+
+
+chess::bitboard knight_attacks(chess::square square)
+{
+    return knight_table[square];
+}
+
+
+chess::bitboard king_attacks(chess::square square)
+{
+    return king_table[square];
+}
+
+
+chess::bitboard pawn_attacks(chess::side side, chess::square square)
+{
+    return side == chess::side_white ? white_pawn_table[square] : black_pawn_table[square];
+}
+
+
+chess::bitboard bishop_attacks(chess::square square, chess::bitboard occupied)
+{
+    return slide(square, occupied, {{{1, 1}, {-1, 1}, {-1, -1}, {1, -1}}});
+}
+
+
+chess::bitboard rook_attacks(chess::square square, chess::bitboard occupied)
+{
+    return slide(square, occupied, {{{1, 0}, {0, 1}, {-1, 0}, {0, -1}}});
+}
+
+
+chess::bitboard side_set(const chess::board& board, chess::side side)
+{
+    return board.piece_set(chess::piece_pawn, side)
+        | board.piece_set(chess::piece_rook, side)
+        | board.piece_set(chess::piece_knight, side)
+        | board.piece_set(chess::piece_bishop, side)
+        | board.piece_set(chess::piece_queen, side)
+        | board.piece_set(chess::piece_king, side);
+}
+
+
+chess::bitboard occupied_set(const chess::board& board)
+{
+    return side_set(board, chess::side_white) | side_set(board, chess::side_black);
+}
+
+
+chess::bitboard attackers(const chess::board& board, chess::square square, chess::bitboard occupied)
+{
+    chess::bitboard queens = board.piece_set(chess::piece_queen, chess::side_white) | board.piece_set(chess::piece_queen, chess::side_black);
+    chess::bitboard rooks = board.piece_set(chess::piece_rook, chess::side_white) | board.piece_set(chess::piece_rook, chess::side_black) | queens;
+    chess::bitboard bishops = board.piece_set(chess::piece_bishop, chess::side_white) | board.piece_set(chess::piece_bishop, chess::side_black) | queens;
+    chess::bitboard knights = board.piece_set(chess::piece_knight, chess::side_white) | board.piece_set(chess::piece_knight, chess::side_black);
+    chess::bitboard kings = board.piece_set(chess::piece_king, chess::side_white) | board.piece_set(chess::piece_king, chess::side_black);
+
+    // a pawn of one side attacks the square if a pawn of the other side on the square would attack it
+    chess::bitboard pawns = (pawn_attacks(chess::side_black, square) & board.piece_set(chess::piece_pawn, chess::side_white))
+        | (pawn_attacks(chess::side_white, square) & board.piece_set(chess::piece_pawn, chess::side_black));
+
+    return ((rook_attacks(square, occupied) & rooks)
+        | (bishop_attacks(square, occupied) & bishops)
+        | (knight_attacks(square) & knights)
+        | (king_attacks(square) & kings)
+        | pawns) & occupied;
+}
+
+
+bool is_attacked(const chess::board& board, chess::square square, chess::side by)
+{
+    return attackers(board, square, occupied_set(board)) & side_set(board, by);
+}
+
+
+bool king_attacked(const chess::board& board, chess::side side)
+{
+    chess::bitboard king = board.piece_set(chess::piece_king, side);
+
+    if(king == 0)
+    {
+        return false;
+    }
+
+    chess::square square = static_cast<chess::square>(std::countr_zero(static_cast<std::uint64_t>(king)));
+    return is_attacked(board, square, side == chess::side_white ? chess::side_black : chess::side_white);
+}
+
+
+bool in_check(const chess::position& position)
+{
+    return king_attacked(position.get_board(), position.get_turn());
+}
+
+
+bool gives_check(const chess::position& position, const chess::move& move)
+{
+    return in_check(position.copy_move(move));
+}
+
+
+}
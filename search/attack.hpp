@@ -0,0 +1,43 @@
+#ifndef ATTACK_HPP
+#define ATTACK_HPP
+
+#include <chess/chess.hpp>
+
+
+namespace search
+{
+
+
+// Squares attacked by a piece standing on a square. Sliders stop at (and include) the first occupied square.
+chess::bitboard knight_attacks(chess::square square);
+chess::bitboard king_attacks(chess::square square);
+chess::bitboard pawn_attacks(chess::side side, chess::square square);
+chess::bitboard bishop_attacks(chess::square square, chess::bitboard occupied);
+chess::bitboard rook_attacks(chess::square square, chess::bitboard occupied);
+
+// All pieces of a side.
+chess::bitboard side_set(const chess::board& board, chess::side side);
+
+// All pieces on the board.
+chess::bitboard occupied_set(const chess::board& board);
+
+// Pieces of both sides attacking a square, given which squares are considered occupied.
+chess::bitboard attackers(const chess::board& board, chess::square square, chess::bitboard occupied);
+
+// True if any piece of the side attacks the square.
+bool is_attacked(const chess::board& board, chess::square square, chess::side by);
+
+// True if the king of the side is attacked.
+bool king_attacked(const chess::board& board, chess::side side);
+
+// True if the side to move is in check.
+bool in_check(const chess::position& position);
+
+// True if the move puts the opponent in check.
+bool gives_check(const chess::position& position, const chess::move& move);
+
+
+}
+
+
+#endif
@@ -0,0 +1,269 @@
+#ifndef BENCH_HPP
+#define BENCH_HPP
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <chess/chess.hpp>
+#include <uci/uci.hpp>
+
+#include "movegen.hpp"
+#include "see.hpp"
+
+
+namespace search
+{
+
+
+// Fixed positions used to compare the amount of work done by different versions of a search.
+const std::vector<std::string> bench_positions = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1",
+    "8/8/8/4k3/8/8/4P3/4K3 w - - 0 1"
+};
+
+
+/**
+ * Searches every bench position to a fixed depth from an empty table and prints node counts.
+ * The engine has to provide searched_nodes() and search_allocations() for the last search.
+ * Debug builds fail the bench if the search allocated below the root.
+ *
+ * @param engine    Engine to benchmark
+ * @param depth     Search depth in plies
+ */
+template<typename engine_type>
+int bench(engine_type& engine, int depth)
+{
+    unsigned long long total_nodes = 0;
+    std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+
+    for(const std::string& fen: bench_positions)
+    {
+        uci::search_limit limit;
+        limit.depth = depth;
+
+        uci::search_info info;
+        std::atomic_bool ponder = false;
+        std::atomic_bool stop = false;
+
+        engine.reset();
+        engine.setup(chess::position::from_fen(fen), {});
+        uci::search_result result = engine.search(limit, info, ponder, stop);
+
+        std::cout << fen << ": bestmove " << result.best.to_lan() << " nodes " << engine.searched_nodes() << std::endl;
+        total_nodes += engine.searched_nodes();
+
+#ifndef NDEBUG
+        if(engine.search_allocations() != 0)
+        {
+            std::cout << fen << ": " << engine.search_allocations() << " heap allocations below the root" << std::endl;
+            return 1;
+        }
+#endif
+    }
+
+    std::chrono::duration<double> elapsed_time = std::chrono::steady_clock::now() - start_time;
+
+    std::cout << "depth " << depth << std::endl;
+    std::cout << "nodes " << total_nodes << std::endl;
+    std::cout << "time " << static_cast<int>(elapsed_time.count() * 1000) << std::endl;
+    std::cout << "nps " << static_cast<unsigned long long>(total_nodes / elapsed_time.count()) << std::endl;
+
+    return 0;
+}
+
+
+/**
+ * Time to depth of the bench positions with 1, 2, 4, 8 and 16 search threads, for measuring how the search scales.
+ * The engine has to provide the Threads option.
+ *
+ * @param engine    Engine to benchmark
+ * @param depth     Search depth in plies
+ */
+template<typename engine_type>
+int smp_bench(engine_type& engine, int depth)
+{
+    double single_thread_time = 0.0;
+
+    for(int threads: {1, 2, 4, 8, 16})
+    {
+        engine.opt.set("Threads", std::to_string(threads));
+
+        unsigned long long total_nodes = 0;
+        std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+
+        for(const std::string& fen: bench_positions)
+        {
+            uci::search_limit limit;
+            limit.depth = depth;
+
+            uci::search_info info;
+            std::atomic_bool ponder = false;
+            std::atomic_bool stop = false;
+
+            engine.reset();
+            engine.setup(chess::position::from_fen(fen), {});
+            engine.search(limit, info, ponder, stop);
+
+            total_nodes += engine.searched_nodes();
+        }
+
+        std::chrono::duration<double> elapsed_time = std::chrono::steady_clock::now() - start_time;
+
+        if(threads == 1)
+        {
+            single_thread_time = elapsed_time.count();
+        }
+
+        std::cout << "threads " << threads
+            << " time " << static_cast<int>(elapsed_time.count() * 1000)
+            << " nodes " << total_nodes
+            << " speedup " << single_thread_time / elapsed_time.count() << std::endl;
+    }
+
+    return 0;
+}
+
+
+/**
+ * Nodes of a fixed depth search of the bench positions with all forward pruning on, with each kind switched off in turn,
+ * and with all of them off, so that the share of the tree each one removes can be compared.
+ * The engine has to provide the RFP, Futility, Razoring and LMP options.
+ *
+ * @param engine    Engine to benchmark
+ * @param depth     Search depth in plies
+ */
+template<typename engine_type>
+int pruning_bench(engine_type& engine, int depth)
+{
+    const std::vector<std::string> options = {"RFP", "Futility", "Razoring", "LMP"};
+
+    auto total_nodes = [&]()
+    {
+        unsigned long long nodes = 0;
+
+        for(const std::string& fen: bench_positions)
+        {
+            uci::search_limit limit;
+            limit.depth = depth;
+
+            uci::search_info info;
+            std::atomic_bool ponder = false;
+            std::atomic_bool stop = false;
+
+            engine.reset();
+            engine.setup(chess::position::from_fen(fen), {});
+            engine.search(limit, info, ponder, stop);
+
+            nodes += engine.searched_nodes();
+        }
+
+        return nodes;
+    };
+
+    auto set_all = [&](const std::string& value)
+    {
+        for(const std::string& name: options)
+        {
+            engine.opt.set(name, value);
+        }
+    };
+
+    set_all("true");
+    unsigned long long all_nodes = total_nodes();
+    std::cout << "all on nodes " << all_nodes << std::endl;
+
+    // The reduction of one kind is how many more nodes the search needs without it
+    for(const std::string& name: options)
+    {
+        engine.opt.set(name, "false");
+        unsigned long long nodes = total_nodes();
+        engine.opt.set(name, "true");
+
+        std::cout << name << " off nodes " << nodes
+            << " reduction " << 100.0 * (1.0 - static_cast<double>(all_nodes) / nodes) << "%" << std::endl;
+    }
+
+    set_all("false");
+    unsigned long long none_nodes = total_nodes();
+    set_all("true");
+
+    std::cout << "all off nodes " << none_nodes
+        << " reduction " << 100.0 * (1.0 - static_cast<double>(all_nodes) / none_nodes) << "%" << std::endl;
+
+    return 0;
+}
+
+
+/**
+ * Times see() and see_ge() over the captures of the bench positions and prints the cost of a call.
+ *
+ * @param iterations    Number of passes over all captures
+ */
+inline int see_bench(int iterations)
+{
+    std::vector<std::pair<chess::position, chess::move>> captures;
+
+    for(const std::string& fen: bench_positions)
+    {
+        chess::position state = chess::position::from_fen(fen);
+        move_list<chess::move> moves;
+        generate_captures(state, chess::square_none, moves);
+
+        for(const chess::move& move: moves)
+        {
+            captures.push_back({state, move});
+        }
+    }
+
+    if(captures.empty())
+    {
+        return 1;
+    }
+
+    // the sum keeps the calls from being optimized away
+    long long sum = 0;
+    std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+
+    for(int i = 0; i < iterations; i++)
+    {
+        for(const auto& [state, move]: captures)
+        {
+            sum += see(state, move);
+        }
+    }
+
+    std::chrono::duration<double, std::nano> see_time = std::chrono::steady_clock::now() - start_time;
+    start_time = std::chrono::steady_clock::now();
+
+    for(int i = 0; i < iterations; i++)
+    {
+        for(const auto& [state, move]: captures)
+        {
+            sum += see_ge(state, move, 0);
+        }
+    }
+
+    std::chrono::duration<double, std::nano> see_ge_time = std::chrono::steady_clock::now() - start_time;
+    double calls = static_cast<double>(iterations) * captures.size();
+
+    std::cout << "captures " << captures.size() << " checksum " << sum << std::endl;
+    std::cout << "see ns/call " << see_time.count() / calls << std::endl;
+    std::cout << "see_ge ns/call " << see_ge_time.count() / calls << std::endl;
+
+    return 0;
+}
+
+
+}
+
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef BOOK_HPP
+#define BOOK_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <string>
+
+#include <chess/chess.hpp>
+
+
+namespace search
+{
+
+
+/**
+ * Polyglot opening book. The book file is memory mapped and binary searched in place, so opening it is instant
+ * and it takes no memory beyond the pages that are read.
+ *
+ * Polyglot keys are not the zobrist keys of libchess, they are built from the fixed table of 781 random numbers
+ * that every Polyglot book uses.
+ */
+class opening_book
+{
+public:
+    opening_book() = default;
+    ~opening_book();
+
+    opening_book(const opening_book&) = delete;
+    opening_book& operator=(const opening_book&) = delete;
+
+    /**
+     * Maps a book, closing the one that was open. On failure no book is open.
+     *
+     * @param path          Polyglot .bin file
+     * @return              Empty if the book can be used, otherwise what went wrong
+     */
+    std::optional<std::string> open(const std::string& path);
+
+    void close();
+
+    bool is_open() const;
+
+    /**
+     * Book move of a position. It is picked at random in proportion to the weights of the book, or the move
+     * with the highest weight if best is set. Moves that are not legal in the position are never returned.
+     */
+    std::optional<chess::move> probe(const chess::position& position, bool best, std::mt19937& random) const;
+
+    // Polyglot key of a position.
+    std::uint64_t key(const chess::position& position) const;
+
+private:
+    // Entries are 16 bytes, big endian: key (8), move (2), weight (2), learn (4).
+    static constexpr std::size_t entry_size = 16;
+
+    const unsigned char* data = nullptr;
+    std::size_t size = 0;
+
+    std::uint64_t entry_key(std::size_t index) const;
+    std::uint16_t entry_move(std::size_t index) const;
+    std::uint16_t entry_weight(std::size_t index) const;
+};
+
+
+}
+
+
+#endif
@@ -0,0 +1,279 @@
+#include <algorithm>
+#include <bit>
+#include <cstdlib>
+#include <string_view>
+#include <vector>
+
+#include "endgame.hpp"
+#include "kpk.hpp"
+#include "values.hpp"
+
+
+namespace search
+{
+
+
+namespace
+{
+
+// Scores an ending from the side that is ahead.
+using evaluator = score_t (*)(const chess::position& position, chess::side strong);
+
+struct endgame
+{
+    std::uint64_t key;
+    chess::side strong;
+    evaluator function;
+};
+
+constexpr chess::piece key_pieces[] = {chess::piece_pawn, chess::piece_rook, chess::piece_knight, chess::piece_bishop, chess::piece_queen};
+
+// Pieces of one side in a material key.
+constexpr std::uint64_t side_mask = (std::uint64_t{1} << 20) - 1;
+
+constexpr chess::bitboard dark_squares = 0xaa55aa55aa55aa55;
+
+int count(const chess::board& board, chess::piece piece, chess::side side)
+{
+    return std::popcount(static_cast<std::uint64_t>(board.piece_set(piece, side)));
+}
+
+chess::square first_square(chess::bitboard set)
+{
+    return static_cast<chess::square>(std::countr_zero(static_cast<std::uint64_t>(set)));
+}
+
+chess::side other(chess::side side)
+{
+    return side == chess::side_white ? chess::side_black : chess::side_white;
+}
+
+int distance(chess::square a, chess::square b)
+{
+    return std::max(std::abs(a % 8 - b % 8), std::abs(a / 8 - b / 8));
+}
+
+// Larger the nearer the square is to the edge.
+int push_to_edge(chess::square square)
+{
+    int file_distance = std::min(square % 8, 7 - square % 8);
+    int rank_distance = std::min(square / 8, 7 - square / 8);
+    return 90 - (7 * file_distance * file_distance / 2 + 7 * rank_distance * rank_distance / 2);
+}
+
+// Larger the nearer the square is to a1 or h8.
+int push_to_corner(chess::square square)
+{
+    return std::abs(7 - square / 8 - square % 8);
+}
+
+// Larger the nearer the squares are to each other.
+int push_close(chess::square a, chess::square b)
+{
+    return 140 - 20 * distance(a, b);
+}
+
+int push_away(chess::square a, chess::square b)
+{
+    return 120 - push_close(a, b);
+}
+
+chess::square king_square(const chess::board& board, chess::side side)
+{
+    return first_square(board.piece_set(chess::piece_king, side));
+}
+
+int material(const chess::board& board, chess::side side)
+{
+    int result = 0;
+
+    for(chess::piece piece: key_pieces)
+    {
+        result += piece_value(piece) * count(board, piece, side);
+    }
+
+    return result;
+}
+
+// Enough material to mate a bare king by force.
+bool has_mating_material(const chess::board& board, chess::side side)
+{
+    chess::bitboard bishops = board.piece_set(chess::piece_bishop, side);
+
+    return count(board, chess::piece_queen, side) > 0 || count(board, chess::piece_rook, side) > 0
+        || (bishops != 0 && count(board, chess::piece_knight, side) > 0)
+        || ((bishops & dark_squares) != 0 && (bishops & ~dark_squares) != 0);
+}
+
+// Mating material against a bare king: drive the king to the edge and bring the own king close.
+score_t evaluate_kxk(const chess::position& position, chess::side strong)
+{
+    const chess::board& board = position.get_board();
+    chess::square strong_king = king_square(board, strong);
+    chess::square weak_king = king_square(board, other(strong));
+
+    return known_win + material(board, strong) + push_to_edge(weak_king) + push_close(strong_king, weak_king);
+}
+
+// The pawn either queens or not, the bitbase knows which.
+score_t evaluate_kpk(const chess::position& position, chess::side strong)
+{
+    const chess::board& board = position.get_board();
+    chess::square pawn = first_square(board.piece_set(chess::piece_pawn, strong));
+
+    if(!kpk_win(strong, king_square(board, strong), pawn, king_square(board, other(strong)), position.get_turn()))
+    {
+        return 0;
+    }
+
+    int relative_rank = strong == chess::side_white ? pawn / 8 : 7 - pawn / 8;
+    return known_win + piece_value(chess::piece_pawn) + 10 * relative_rank;
+}
+
+// Mate is only possible in a corner of the colour of the bishop.
+score_t evaluate_kbnk(const chess::position& position, chess::side strong)
+{
+    const chess::board& board = position.get_board();
+    chess::square strong_king = king_square(board, strong);
+    chess::square weak_king = king_square(board, other(strong));
+    bool dark_bishop = (board.piece_set(chess::piece_bishop, strong) & dark_squares) != 0;
+
+    // a1 and h8 are dark, mirror the board for a light square bishop
+    chess::square corner_square = dark_bishop ? weak_king : static_cast<chess::square>(weak_king ^ 7);
+
+    return known_win + material(board, strong) + push_close(strong_king, weak_king) + 100 * push_to_corner(corner_square);
+}
+
+// Won, but slowly: the rook is kept away from the king while the weak king is pushed to the edge.
+score_t evaluate_kqkr(const chess::position& position, chess::side strong)
+{
+    const chess::board& board = position.get_board();
+    chess::square strong_king = king_square(board, strong);
+    chess::square weak_king = king_square(board, other(strong));
+
+    return piece_value(chess::piece_queen) - piece_value(chess::piece_rook) + push_to_edge(weak_king) + push_close(strong_king, weak_king);
+}
+
+// Usually drawn, slightly better with the weak king on the edge.
+score_t evaluate_krkb(const chess::position& position, chess::side strong)
+{
+    return push_to_edge(king_square(position.get_board(), other(strong)));
+}
+
+// Usually drawn, better with the weak king on the edge and the knight cut off from it.
+score_t evaluate_krkn(const chess::position& position, chess::side strong)
+{
+    const chess::board& board = position.get_board();
+    chess::side weak = other(strong);
+    chess::square weak_king = king_square(board, weak);
+    chess::square knight = first_square(board.piece_set(chess::piece_knight, weak));
+
+    return push_to_edge(weak_king) + push_away(weak_king, knight);
+}
+
+// Neither side can force mate.
+score_t evaluate_draw(const chess::position&, chess::side)
+{
+    return 0;
+}
+
+// Material key of an ending written like "KBNK", the pieces of the strong side first.
+std::uint64_t signature_key(std::string_view signature, chess::side strong)
+{
+    std::uint64_t key = 0;
+    chess::side side = other(strong);
+
+    for(char code: signature)
+    {
+        if(code == 'K')
+        {
+            side = other(side);
+            continue;
+        }
+
+        int piece = static_cast<int>(std::string_view("PRNBQ").find(code));
+        key += std::uint64_t{1} << (4 * (5 * side + piece));
+    }
+
+    return key;
+}
+
+std::vector<endgame> make_endgames()
+{
+    const std::pair<std::string_view, evaluator> signatures[] = {
+        {"KPK", evaluate_kpk},
+        {"KBNK", evaluate_kbnk},
+        {"KQKR", evaluate_kqkr},
+        {"KRKB", evaluate_krkb},
+        {"KRKN", evaluate_krkn},
+        {"KK", evaluate_draw},
+        {"KNK", evaluate_draw},
+        {"KBK", evaluate_draw},
+        {"KNNK", evaluate_draw}
+    };
+
+    std::vector<endgame> result;
+
+    for(const auto& [signature, function]: signatures)
+    {
+        for(chess::side strong: {chess::side_white, chess::side_black})
+        {
+            result.push_back({signature_key(signature, strong), strong, function});
+        }
+    }
+
+    return result;
+}
+
+const std::vector<endgame> endgames = make_endgames();
+
+}
+
+
+std::uint64_t material_key(const chess::board& board)
+{
+    std::uint64_t key = 0;
+
+    for(chess::side side: {chess::side_white, chess::side_black})
+    {
+        for(chess::piece piece: key_pieces)
+        {
+            key += static_cast<std::uint64_t>(count(board, piece, side)) << (4 * (5 * side + piece));
+        }
+    }
+
+    return key;
+}
+
+
+std::optional<score_t> evaluate_endgame(const chess::position& position)
+{
+    const chess::board& board = position.get_board();
+    std::uint64_t key = material_key(board);
+
+    for(const endgame& entry: endgames)
+    {
+        if(entry.key == key)
+        {
+            score_t value = entry.function(position, entry.strong);
+            return position.get_turn() == entry.strong ? value : -value;
+        }
+    }
+
+    // Any mating material against a bare king
+    for(chess::side strong: {chess::side_white, chess::side_black})
+    {
+        chess::side weak = other(strong);
+
+        if((key >> (20 * weak) & side_mask) == 0 && has_mating_material(board, strong))
+        {
+            score_t value = evaluate_kxk(position, strong);
+            return position.get_turn() == strong ? value : -value;
+        }
+    }
+
+    return std::nullopt;
+}
+
+
+}
@@ -0,0 +1,34 @@
+#ifndef ENDGAME_HPP
+#define ENDGAME_HPP
+
+#include <cstdint>
+#include <optional>
+
+#include <chess/chess.hpp>
+
+#include "score.hpp"
+
+
+namespace search
+{
+
+
+// Score of an ending that is won with correct play, above any ordinary evaluation and below tablebase wins.
+constexpr score_t known_win = 10000;
+
+
+// Number of each piece but the king of both sides, 4 bits each, identifying the material of a position.
+std::uint64_t material_key(const chess::board& board);
+
+/**
+ * Evaluation of basic endings that an ordinary evaluation misjudges, from the side to move.
+ * The ending is picked by the material key: KPK from a bitbase, KBNK, KQKR, KRKB and KRKN by driving the weak king,
+ * any mating material against a bare king, and draws by insufficient material. Other positions return nothing.
+ */
+std::optional<score_t> evaluate_endgame(const chess::position& position);
+
+
+}
+
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef HASH_HISTORY_HPP
+#define HASH_HISTORY_HPP
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include "move_order.hpp"
+
+
+namespace search
+{
+
+
+// Plies without a capture or pawn move after which the game is drawn.
+constexpr int fifty_move_plies = 100;
+
+
+/**
+ * Hashes of the positions from the game setup to the current node of the search, used to find repetitions.
+ * Only positions since the last capture, pawn move or null move can repeat, so each entry remembers how far back
+ * that was and a check looks at no more entries than that. The stack is stored in place and never allocates.
+ */
+class hash_history
+{
+public:
+    void clear()
+    {
+        count = 0;
+    }
+
+    // Position reached by a move, with the halfmove clock after the move.
+    void push(std::uint64_t key, int halfmove_clock)
+    {
+        int reversible = std::min(halfmove_clock, fifty_move_plies);
+
+        if(count > 0)
+        {
+            reversible = std::min(reversible, entries[count - 1].reversible + 1);
+        }
+
+        assert(count < capacity);
+        entries[count++] = {key, reversible};
+    }
+
+    // Position reached by a null move. Nothing before it can repeat in a real game.
+    void push_null(std::uint64_t key)
+    {
+        assert(count < capacity);
+        entries[count++] = {key, 0};
+    }
+
+    void pop()
+    {
+        count--;
+    }
+
+    // Drops the entries the last position can not repeat, so that a long game leaves room for the search.
+    void drop_unreachable()
+    {
+        std::size_t keep = std::min(count, static_cast<std::size_t>(entries[count - 1].reversible) + 1);
+        std::copy(entries.begin() + (count - keep), entries.begin() + count, entries.begin());
+        count = keep;
+    }
+
+    // True if the last position occurred before with the same side to move, within the reversible plies.
+    bool is_repetition() const
+    {
+        const entry& last = entries[count - 1];
+
+        for(int distance = 4; distance <= last.reversible && static_cast<std::size_t>(distance) < count; distance += 2)
+        {
+            if(entries[count - 1 - distance].key == last.key)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+private:
+    // The game part is at most fifty_move_plies + 1 entries after drop_unreachable, the search adds one per ply.
+    static constexpr std::size_t capacity = fifty_move_plies + 1 + max_ply;
+
+    struct entry
+    {
+        std::uint64_t key;
+        int reversible;
+    };
+
+    std::array<entry, capacity> entries;
+    std::size_t count = 0;
+};
+
+
+}
+
+
+#endif
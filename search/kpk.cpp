@@ -0,0 +1,236 @@
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#include "kpk.hpp"
+
+
+namespace search
+{
+
+
+namespace
+{
+
+// Positions with white to move and the white pawn on files a-d, ranks 2-7, then the same with black to move:
+// strong king (6 bits), weak king (6 bits), side to move (1 bit), pawn file (2 bits), 7 - pawn rank (3 bits).
+constexpr std::size_t position_count = 2 * 24 * 64 * 64;
+
+// Results are flags, so that the results of the children of a position can be combined with or.
+enum result: std::uint8_t
+{
+    invalid = 0,
+    unknown = 1,
+    draw = 2,
+    win = 4
+};
+
+std::size_t index(int to_move, int strong_king, int weak_king, int pawn)
+{
+    return strong_king | weak_king << 6 | to_move << 12 | (pawn % 8) << 13 | (6 - pawn / 8) << 15;
+}
+
+constexpr int distance(int a, int b)
+{
+    int files = a % 8 - b % 8;
+    int ranks = a / 8 - b / 8;
+    return std::max(files < 0 ? -files : files, ranks < 0 ? -ranks : ranks);
+}
+
+// Squares a king on each square can step to, one bit per square.
+constexpr std::array<std::uint64_t, 64> make_king_steps()
+{
+    std::array<std::uint64_t, 64> result{};
+
+    for(int square = 0; square < 64; square++)
+    {
+        for(int other = 0; other < 64; other++)
+        {
+            if(distance(square, other) == 1)
+            {
+                result[square] |= std::uint64_t{1} << other;
+            }
+        }
+    }
+
+    return result;
+}
+
+constexpr std::array<std::uint64_t, 64> king_steps = make_king_steps();
+
+bool pawn_attacks(int pawn, int square)
+{
+    return square / 8 == pawn / 8 + 1 && std::abs(square % 8 - pawn % 8) == 1;
+}
+
+// Result of a position from its squares alone, unknown if its children have to be looked at.
+result initial(int to_move, int strong_king, int weak_king, int pawn)
+{
+    int promotion = pawn + 8;
+
+    if(distance(strong_king, weak_king) <= 1 || strong_king == pawn || weak_king == pawn
+        || (to_move == 0 && pawn_attacks(pawn, weak_king)))
+    {
+        return invalid;
+    }
+
+    // The pawn promotes and the new queen can not be taken
+    if(to_move == 0 && pawn / 8 == 6 && strong_king != promotion && weak_king != promotion
+        && (distance(weak_king, promotion) > 1 || distance(strong_king, promotion) == 1))
+    {
+        return win;
+    }
+
+    if(to_move == 1)
+    {
+        bool can_move = false;
+
+        for(std::uint64_t steps = king_steps[weak_king]; steps != 0; steps &= steps - 1)
+        {
+            int step = std::countr_zero(steps);
+
+            if(distance(step, strong_king) > 1 && !pawn_attacks(pawn, step))
+            {
+                can_move = true;
+            }
+        }
+
+        // Stalemate, or the pawn is taken
+        if(!can_move || (distance(weak_king, pawn) == 1 && distance(strong_king, pawn) > 1))
+        {
+            return draw;
+        }
+    }
+
+    return unknown;
+}
+
+// Result of a position from the results of its children, white wants a win and black a draw.
+result from_children(const std::vector<result>& results, int to_move, int strong_king, int weak_king, int pawn)
+{
+    int combined = invalid;
+
+    if(to_move == 0)
+    {
+        for(std::uint64_t steps = king_steps[strong_king]; steps != 0; steps &= steps - 1)
+        {
+            combined |= results[index(1, std::countr_zero(steps), weak_king, pawn)];
+        }
+
+        if(pawn / 8 < 6)
+        {
+            combined |= results[index(1, strong_king, weak_king, pawn + 8)];
+        }
+
+        if(pawn / 8 == 1 && strong_king != pawn + 8 && weak_king != pawn + 8)
+        {
+            combined |= results[index(1, strong_king, weak_king, pawn + 16)];
+        }
+
+        return combined & win ? win : combined & unknown ? unknown : draw;
+    }
+
+    for(std::uint64_t steps = king_steps[weak_king]; steps != 0; steps &= steps - 1)
+    {
+        combined |= results[index(0, strong_king, std::countr_zero(steps), pawn)];
+    }
+
+    return combined & draw ? draw : combined & unknown ? unknown : win;
+}
+
+// Classifies every position, then repeats over the unknown ones until none changes.
+std::array<std::uint64_t, position_count / 64> generate()
+{
+    std::vector<result> results(position_count, invalid);
+    std::vector<std::size_t> open;
+
+    for(int to_move = 0; to_move < 2; to_move++)
+    {
+        for(int file = 0; file < 4; file++)
+        {
+            for(int rank = 1; rank < 7; rank++)
+            {
+                for(int strong_king = 0; strong_king < 64; strong_king++)
+                {
+                    for(int weak_king = 0; weak_king < 64; weak_king++)
+                    {
+                        int pawn = rank * 8 + file;
+                        std::size_t i = index(to_move, strong_king, weak_king, pawn);
+                        results[i] = initial(to_move, strong_king, weak_king, pawn);
+
+                        if(results[i] == unknown)
+                        {
+                            open.push_back(i);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    bool changed = true;
+
+    while(changed)
+    {
+        changed = false;
+
+        for(std::size_t i: open)
+        {
+            if(results[i] == unknown)
+            {
+                int pawn = (6 - static_cast<int>(i >> 15)) * 8 + static_cast<int>(i >> 13 & 3);
+                results[i] = from_children(results, i >> 12 & 1, i & 63, i >> 6 & 63, pawn);
+                changed |= results[i] != unknown;
+            }
+        }
+    }
+
+    // Positions still unknown can not be forced to a win
+    std::array<std::uint64_t, position_count / 64> bits{};
+
+    for(std::size_t i = 0; i < position_count; i++)
+    {
+        if(results[i] == win)
+        {
+            bits[i / 64] |= std::uint64_t{1} << (i % 64);
+        }
+    }
+
+    return bits;
+}
+
+const std::array<std::uint64_t, position_count / 64> bitbase = generate();
+
+}
+
+
+bool kpk_win(chess::side strong, chess::square strong_king, chess::square pawn, chess::square weak_king, chess::side turn)
+{
+    int s = strong_king;
+    int p = pawn;
+    int w = weak_king;
+
+    // The table has the pawn moving up the board on the queen side
+    if(strong == chess::side_black)
+    {
+        s ^= 56;
+        p ^= 56;
+        w ^= 56;
+    }
+
+    if(p % 8 >= 4)
+    {
+        s ^= 7;
+        p ^= 7;
+        w ^= 7;
+    }
+
+    std::size_t i = index(turn == strong ? 0 : 1, s, w, p);
+    return bitbase[i / 64] >> (i % 64) & 1;
+}
+
+
+}
@@ -0,0 +1,27 @@
+#ifndef KPK_HPP
+#define KPK_HPP
+
+#include <chess/chess.hpp>
+
+
+namespace search
+{
+
+
+/**
+ * True if the side with the pawn wins king and pawn against king. Answered from a bitbase of every position
+ * with the pawn on files a to d, built by retrograde analysis when the program starts and stored one bit per position (24 KB).
+ *
+ * @param strong        Side that has the pawn
+ * @param strong_king   King of the side with the pawn
+ * @param pawn          Square of the pawn
+ * @param weak_king     King of the side without the pawn
+ * @param turn          Side to move
+ */
+bool kpk_win(chess::side strong, chess::square strong_king, chess::square pawn, chess::square weak_king, chess::side turn);
+
+
+}
+
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef MOVE_LIST_HPP
+#define MOVE_LIST_HPP
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+
+
+namespace search
+{
+
+
+// More than the legal moves of any position.
+constexpr std::size_t max_moves = 256;
+
+
+/**
+ * List of at most max_moves elements stored in place, so that the search can keep one per ply and never allocate.
+ */
+template<typename T>
+class move_list
+{
+public:
+    using iterator = typename std::array<T, max_moves>::iterator;
+    using const_iterator = typename std::array<T, max_moves>::const_iterator;
+
+    void push_back(const T& value)
+    {
+        assert(count < max_moves);
+        elements[count++] = value;
+    }
+
+    void pop_back()
+    {
+        count--;
+    }
+
+    void clear()
+    {
+        count = 0;
+    }
+
+    std::size_t size() const
+    {
+        return count;
+    }
+
+    bool empty() const
+    {
+        return count == 0;
+    }
+
+    T& operator[](std::size_t index)
+    {
+        return elements[index];
+    }
+
+    const T& operator[](std::size_t index) const
+    {
+        return elements[index];
+    }
+
+    T& back()
+    {
+        return elements[count - 1];
+    }
+
+    iterator begin()
+    {
+        return elements.begin();
+    }
+
+    iterator end()
+    {
+        return elements.begin() + count;
+    }
+
+    const_iterator begin() const
+    {
+        return elements.begin();
+    }
+
+    const_iterator end() const
+    {
+        return elements.begin() + count;
+    }
+
+private:
+    std::array<T, max_moves> elements;
+    std::size_t count = 0;
+};
+
+
+}
+
+
+#endif
@@ -0,0 +1,187 @@
+#include <algorithm>
+
+#include "move_order.hpp"
+#include "movegen.hpp"
+#include "transposition_table.hpp"
+#include "values.hpp"
+
+
+namespace search
+{
+
+
+namespace
+{
+
+// score bands, history scores stay below killer_score
+constexpr double table_score = 4000000.0;
+constexpr double capture_score = 3000000.0;
+constexpr double killer_score = 2000000.0;
+constexpr double countermove_score = 1900000.0;
+
+}
+
+
+move_order::move_order()
+{
+    clear();
+}
+
+
+void move_order::clear()
+{
+    for(auto& moves: killers)
+    {
+        moves.fill(chess::move());
+    }
+
+    for(auto& side: history)
+    {
+        for(auto& from: side)
+        {
+            from.fill(0);
+        }
+    }
+
+    for(auto& from: countermoves)
+    {
+        from.fill(chess::move());
+    }
+}
+
+
+void move_order::new_search()
+{
+    for(auto& moves: killers)
+    {
+        moves.fill(chess::move());
+    }
+
+    for(auto& side: history)
+    {
+        for(auto& from: side)
+        {
+            for(int& value: from)
+            {
+                value /= 2;
+            }
+        }
+    }
+}
+
+
+void move_order::score(const chess::position& state, const chess::move& table_move, int ply, const chess::move& previous,
+                       std::vector<std::pair<chess::move, double>>& output) const
+{
+    const chess::board& board = state.get_board();
+    chess::side side = state.get_turn();
+    // A null move, as at the root, has no squares to look up a countermove by
+    bool has_counter = pack_move(previous) != 0;
+    chess::move counter = has_counter ? countermoves[previous.from][previous.to] : chess::move();
+
+    for(const chess::move& move: state.moves())
+    {
+        double value;
+
+        if(same_move(move, table_move))
+        {
+            value = table_score;
+        }
+        else if(captured_piece(board, move) != chess::piece_none || move.promote != chess::piece_none)
+        {
+            value = capture_score + mvv_lva(state, move);
+        }
+        else if(same_move(move, killers[ply][0]))
+        {
+            value = killer_score + 1;
+        }
+        else if(same_move(move, killers[ply][1]))
+        {
+            value = killer_score;
+        }
+        else if(has_counter && same_move(move, counter))
+        {
+            value = countermove_score;
+        }
+        else
+        {
+            value = history[side][move.from][move.to];
+        }
+
+        output.push_back({move, value});
+    }
+}
+
+
+void move_order::update(chess::side side, const chess::move& move, int depth, int ply, const chess::move& previous, const move_list<chess::move>& tried)
+{
+    if(!same_move(killers[ply][0], move))
+    {
+        killers[ply][1] = killers[ply][0];
+        killers[ply][0] = move;
+    }
+
+    if(pack_move(previous) != 0)
+    {
+        countermoves[previous.from][previous.to] = move;
+    }
+
+    int bonus = depth * depth;
+    add_history(side, move, bonus);
+
+    for(const chess::move& other: tried)
+    {
+        add_history(side, other, -bonus);
+    }
+}
+
+
+bool move_order::is_killer(int ply, const chess::move& move) const
+{
+    return same_move(move, killers[ply][0]) || same_move(move, killers[ply][1]);
+}
+
+
+const chess::move& move_order::killer(int ply, int slot) const
+{
+    return killers[ply][slot];
+}
+
+
+const chess::move& move_order::countermove(const chess::move& previous) const
+{
+    return countermoves[previous.from][previous.to];
+}
+
+
+int move_order::history_score(chess::side side, const chess::move& move) const
+{
+    return history[side][move.from][move.to];
+}
+
+
+int move_order::mvv_lva(const chess::position& state, const chess::move& move)
+{
+    const chess::board& board = state.get_board();
+    chess::piece victim = captured_piece(board, move);
+    chess::piece attacker = board.get(move.from).second;
+
+    int value = piece_value(victim);
+
+    if(move.promote != chess::piece_none)
+    {
+        value += piece_value(move.promote) - piece_value(chess::piece_pawn);
+    }
+
+    return value * 16 - piece_value(attacker) / 100;
+}
+
+
+void move_order::add_history(chess::side side, const chess::move& move, int bonus)
+{
+    int& value = history[side][move.from][move.to];
+    value = std::clamp(value + bonus, -history_max, history_max);
+}
+
+
+}
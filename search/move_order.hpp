@@ -0,0 +1,88 @@
+#ifndef MOVE_ORDER_HPP
+#define MOVE_ORDER_HPP
+
+#include <array>
+#include <utility>
+#include <vector>
+
+#include <chess/chess.hpp>
+
+#include "move_list.hpp"
+
+
+namespace search
+{
+
+
+// Deepest ply the search keeps per-ply information for.
+constexpr int max_ply = 128;
+
+
+/**
+ * Move ordering heuristics that do not need to evaluate positions.
+ * Moves are ordered: table move, captures by MVV-LVA, killers, countermove, quiets by history.
+ */
+class move_order
+{
+public:
+    move_order();
+
+    // Forget everything, for a new game.
+    void clear();
+
+    // Prepare for a new search. Killers are position specific and dropped, history is aged.
+    void new_search();
+
+    /**
+     * Scores the legal moves of a position, higher scores should be searched first.
+     *
+     * @param state         Position to move in
+     * @param table_move    Best move from the transposition table, may be a null move
+     * @param ply           Distance from root
+     * @param previous      Move that led to the position, may be a null move
+     * @param output        Moves and scores
+     */
+    void score(const chess::position& state, const chess::move& table_move, int ply, const chess::move& previous,
+               std::vector<std::pair<chess::move, double>>& output) const;
+
+    /**
+     * Rewards a quiet move that caused a beta cutoff, and penalizes the quiet moves searched before it.
+     *
+     * @param side      Side that made the move
+     * @param move      Move that caused the cutoff
+     * @param depth     Remaining depth of the node
+     * @param ply       Distance from root
+     * @param previous  Move that led to the node, may be a null move
+     * @param tried     Quiet moves searched before the cutoff move
+     */
+    void update(chess::side side, const chess::move& move, int depth, int ply, const chess::move& previous, const move_list<chess::move>& tried);
+
+    bool is_killer(int ply, const chess::move& move) const;
+
+    // Killer slot (0 or 1) of a ply, may be a null move.
+    const chess::move& killer(int ply, int slot) const;
+
+    // Move that last refuted the previous move, may be a null move.
+    const chess::move& countermove(const chess::move& previous) const;
+
+    // History score of a quiet move.
+    int history_score(chess::side side, const chess::move& move) const;
+
+    // Score of a capture or promotion, most valuable victim first, then least valuable attacker.
+    static int mvv_lva(const chess::position& state, const chess::move& move);
+
+private:
+    static constexpr int history_max = 1 << 20;
+
+    std::array<std::array<chess::move, 2>, max_ply> killers;
+    std::array<std::array<std::array<int, 64>, 64>, chess::sides> history;
+    std::array<std::array<chess::move, 64>, 64> countermoves;
+
+    void add_history(chess::side side, const chess::move& move, int bonus);
+};
+
+
+}
+
+
+#endif
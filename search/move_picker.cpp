@@ -0,0 +1,257 @@
+#include <algorithm>
+
+#include "move_picker.hpp"
+#include "movegen.hpp"
+#include "see.hpp"
+#include "transposition_table.hpp"
+
+
+namespace search
+{
+
+
+void picker_stats::clear()
+{
+    table = 0;
+    captures = 0;
+    killers = 0;
+    quiets = 0;
+    bad_captures = 0;
+}
+
+
+std::string picker_stats::to_string() const
+{
+    return "move picker stages table " + std::to_string(table)
+        + " captures " + std::to_string(captures)
+        + " killers " + std::to_string(killers)
+        + " quiets " + std::to_string(quiets)
+        + " bad captures " + std::to_string(bad_captures);
+}
+
+
+move_picker::move_picker(chess::position& state, const chess::move& table_move, int ply, const chess::move& previous, const move_order& order, picker_stats& stats,
+                         picker_buffers& buffers):
+state(state), table_move(table_move), ply(ply), previous(previous), en_passant(en_passant_square(state, previous)), order(order), stats(stats),
+current(stage::table), captures_only(false), captures(buffers.captures), quiets(buffers.quiets), bad_captures(buffers.bad_captures), moves(buffers.moves),
+specials(), index(0), bad(false)
+{
+    captures.clear();
+    quiets.clear();
+    bad_captures.clear();
+}
+
+
+move_picker::move_picker(chess::position& state, const chess::move& previous, const move_order& order, picker_stats& stats, picker_buffers& buffers):
+state(state), table_move(), ply(0), previous(previous), en_passant(en_passant_square(state, previous)), order(order), stats(stats),
+current(stage::generate), captures_only(true), captures(buffers.captures), quiets(buffers.quiets), bad_captures(buffers.bad_captures), moves(buffers.moves),
+specials(), index(0), bad(false)
+{
+    captures.clear();
+    quiets.clear();
+    bad_captures.clear();
+}
+
+
+bool move_picker::next(chess::move& move)
+{
+    switch(current)
+    {
+    case stage::table:
+        current = stage::generate;
+
+        if(pack_move(table_move) != 0 && is_legal(state, table_move))
+        {
+            stats.table++;
+            move = table_move;
+            return true;
+        }
+
+        // the table move is not searched, so it must not be skipped later
+        table_move = chess::move();
+        [[fallthrough]];
+
+    case stage::generate:
+        generate_captures();
+        current = stage::captures;
+        stats.captures++;
+        [[fallthrough]];
+
+    case stage::captures:
+        // selection of the best remaining capture, most nodes cut off after one or two
+        while(index < captures.size())
+        {
+            auto best = std::max_element(captures.begin() + index, captures.end(), [](const auto& a, const auto& b)
+            {
+                return a.second < b.second;
+            });
+
+            std::iter_swap(captures.begin() + index, best);
+            const chess::move& candidate = captures[index++].first;
+
+            if(is_table_move(candidate))
+            {
+                continue;
+            }
+
+            // captures that lose material wait until after the quiet moves
+            if(!see_ge(state, candidate, 0))
+            {
+                bad_captures.push_back(candidate);
+                continue;
+            }
+
+            // generated moves are pseudo-legal, only the ones handed out are checked
+            if(keeps_king_safe(state, candidate))
+            {
+                move = candidate;
+                return true;
+            }
+        }
+
+        if(captures_only)
+        {
+            index = 0;
+            current = stage::bad_captures;
+            stats.bad_captures++;
+            return next(move);
+        }
+
+        specials = {order.killer(ply, 0), order.killer(ply, 1), pack_move(previous) != 0 ? order.countermove(previous) : chess::move()};
+        index = 0;
+        current = stage::killers;
+        stats.killers++;
+        [[fallthrough]];
+
+    case stage::killers:
+        // killers come from other positions, they are checked without generating the quiet moves
+        while(index < specials.size())
+        {
+            chess::move& candidate = specials[index++];
+
+            // a special that is not handed out is cleared, so that the quiet stage does not skip it
+            if(pack_move(candidate) == 0 || is_table_move(candidate) || is_special(candidate, index - 1) || is_capture(candidate)
+                || !is_legal(state, candidate))
+            {
+                candidate = chess::move();
+                continue;
+            }
+
+            move = candidate;
+            return true;
+        }
+
+        generate_quiets();
+
+        // insertion sort is stable like std::stable_sort, but does not allocate a buffer
+        for(std::size_t i = 1; i < quiets.size(); i++)
+        {
+            std::pair<chess::move, int> entry = quiets[i];
+            std::size_t j = i;
+
+            for(; j > 0 && quiets[j - 1].second < entry.second; j--)
+            {
+                quiets[j] = quiets[j - 1];
+            }
+
+            quiets[j] = entry;
+        }
+
+        index = 0;
+        current = stage::quiets;
+        stats.quiets++;
+        [[fallthrough]];
+
+    case stage::quiets:
+        while(index < quiets.size())
+        {
+            const chess::move& candidate = quiets[index++].first;
+
+            if(!is_table_move(candidate) && !is_special(candidate, specials.size()) && keeps_king_safe(state, candidate))
+            {
+                move = candidate;
+                return true;
+            }
+        }
+
+        index = 0;
+        current = stage::bad_captures;
+        stats.bad_captures++;
+        [[fallthrough]];
+
+    case stage::bad_captures:
+        while(index < bad_captures.size())
+        {
+            const chess::move& candidate = bad_captures[index++];
+
+            if(keeps_king_safe(state, candidate))
+            {
+                bad = true;
+                move = candidate;
+                return true;
+            }
+        }
+
+        current = stage::done;
+        [[fallthrough]];
+
+    case stage::done:
+        break;
+    }
+
+    return false;
+}
+
+
+bool move_picker::is_capture(const chess::move& move) const
+{
+    return captured_piece(state.get_board(), move) != chess::piece_none || move.promote != chess::piece_none;
+}
+
+
+void move_picker::generate_captures()
+{
+    moves.clear();
+    search::generate_captures(state, en_passant, moves);
+
+    for(const chess::move& move: moves)
+    {
+        captures.push_back({move, move_order::mvv_lva(state, move)});
+    }
+}
+
+
+void move_picker::generate_quiets()
+{
+    moves.clear();
+    search::generate_quiets(state, moves);
+
+    for(const chess::move& move: moves)
+    {
+        quiets.push_back({move, order.history_score(state.get_turn(), move)});
+    }
+}
+
+
+bool move_picker::is_bad_capture() const
+{
+    return bad;
+}
+
+
+bool move_picker::is_table_move(const chess::move& move) const
+{
+    return same_move(move, table_move);
+}
+
+
+bool move_picker::is_special(const chess::move& move, std::size_t count) const
+{
+    return std::any_of(specials.begin(), specials.begin() + count, [&](const chess::move& special)
+    {
+        return same_move(move, special);
+    });
+}
+
+
+}
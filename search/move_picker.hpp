@@ -0,0 +1,115 @@
+#ifndef MOVE_PICKER_HPP
+#define MOVE_PICKER_HPP
+
+#include <array>
+#include <string>
+#include <utility>
+
+#include <chess/chess.hpp>
+
+#include "move_list.hpp"
+#include "move_order.hpp"
+
+
+namespace search
+{
+
+
+// Number of times each stage of the move picker was reached, for debugging the ordering.
+struct picker_stats
+{
+    unsigned long long table = 0;
+    unsigned long long captures = 0;
+    unsigned long long killers = 0;
+    unsigned long long quiets = 0;
+    unsigned long long bad_captures = 0;
+
+    void clear();
+
+    std::string to_string() const;
+};
+
+
+// Move lists of a picker. They belong to the caller, which keeps one per ply so that the picker never allocates.
+struct picker_buffers
+{
+    // Moves of a stage as generated, before they are scored.
+    move_list<chess::move> moves;
+
+    move_list<std::pair<chess::move, int>> captures;
+    move_list<std::pair<chess::move, int>> quiets;
+    move_list<chess::move> bad_captures;
+};
+
+
+/**
+ * Hands out the moves of a position one at a time, doing work only when the previous stage did not cut off.
+ * Stages: table move, captures by MVV-LVA, killers and countermove, quiets by history, captures that lose material by SEE.
+ * The table move, killers and countermove are checked with is_legal and tried before the moves they would be among are generated,
+ * captures are generated when the capture stage is reached and quiets when the quiet stage is. Generated moves are pseudo-legal
+ * and only checked for leaving the king in check when they are handed out.
+ */
+class move_picker
+{
+public:
+    /**
+     * @param state         Position to move in, left unchanged
+     * @param table_move    Best move from the transposition table, may be a null move
+     * @param ply           Distance from root
+     * @param previous      Move that led to the position, may be a null move
+     * @param order         Killer, countermove and history tables
+     * @param stats         Stage counters
+     * @param buffers       Move lists, their contents are replaced
+     */
+    move_picker(chess::position& state, const chess::move& table_move, int ply, const chess::move& previous, const move_order& order, picker_stats& stats,
+                picker_buffers& buffers);
+
+    // Picker for quiescence search: only captures and queen promotions, by MVV-LVA, without generating quiet moves.
+    // Losing captures still come last. The previous move tells the en passant square.
+    move_picker(chess::position& state, const chess::move& previous, const move_order& order, picker_stats& stats, picker_buffers& buffers);
+
+    // Next move to search, false when all moves have been handed out.
+    bool next(chess::move& move);
+
+    // True if the move is a capture, en passant included, or a promotion in the position.
+    bool is_capture(const chess::move& move) const;
+
+    // True if the last move handed out is a capture that loses material by static exchange evaluation.
+    bool is_bad_capture() const;
+
+private:
+    enum class stage {table, generate, captures, killers, quiets, bad_captures, done};
+
+    chess::position& state;
+    chess::move table_move;
+    int ply;
+    chess::move previous;
+    chess::square en_passant;
+    const move_order& order;
+    picker_stats& stats;
+
+    stage current;
+    bool captures_only;
+    move_list<std::pair<chess::move, int>>& captures;
+    move_list<std::pair<chess::move, int>>& quiets;
+    move_list<chess::move>& bad_captures;
+    move_list<chess::move>& moves;
+
+    // Killers and countermove, those not handed out are cleared.
+    std::array<chess::move, 3> specials;
+    std::size_t index;
+    bool bad;
+
+    void generate_captures();
+    void generate_quiets();
+    bool is_table_move(const chess::move& move) const;
+
+    // True if the move is one of the first count specials.
+    bool is_special(const chess::move& move, std::size_t count) const;
+};
+
+
+}
+
+
+#endif
@@ -0,0 +1,317 @@
+#include <bit>
+#include <cstdint>
+
+#include "movegen.hpp"
+#include "attack.hpp"
+#include "transposition_table.hpp"
+
+
+namespace search
+{
+
+
+namespace
+{
+
+constexpr chess::bitboard bit(int square)
+{
+    return chess::bitboard{1} << square;
+}
+
+// Index of the lowest set square, which is then cleared.
+int pop_square(chess::bitboard& set)
+{
+    int square = std::countr_zero(static_cast<std::uint64_t>(set));
+    set &= set - 1;
+    return square;
+}
+
+chess::move make(int from, int to, chess::piece promote)
+{
+    return chess::move{static_cast<chess::square>(from), static_cast<chess::square>(to), promote};
+}
+
+// Moves of a piece from one square to every square of a set.
+void add_moves(int from, chess::bitboard targets, move_list<chess::move>& output)
+{
+    while(targets)
+    {
+        output.push_back(make(from, pop_square(targets), chess::piece_none));
+    }
+}
+
+// Castling to one side: the squares between king and rook empty, and the king not passing an attacked square.
+bool can_castle(const chess::board& board, chess::side side, chess::bitboard occupied, int king, int direction)
+{
+    int rook = direction > 0 ? king + 3 : king - 4;
+    chess::side other = side == chess::side_white ? chess::side_black : chess::side_white;
+
+    for(int square = king + direction; square != rook; square += direction)
+    {
+        if(occupied & bit(square))
+        {
+            return false;
+        }
+    }
+
+    for(int square = king; square != king + 3 * direction; square += direction)
+    {
+        if(is_attacked(board, static_cast<chess::square>(square), other))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+}
+
+
+chess::square en_passant_square(const chess::position& state, const chess::move& previous)
+{
+    if(pack_move(previous) == 0 || state.get_board().get(previous.to).second != chess::piece_pawn
+        || (previous.to - previous.from != 16 && previous.from - previous.to != 16))
+    {
+        return chess::square_none;
+    }
+
+    return static_cast<chess::square>((previous.from + previous.to) / 2);
+}
+
+
+chess::piece captured_piece(const chess::board& board, const chess::move& move)
+{
+    chess::piece captured = board.get(move.to).second;
+
+    // only en passant moves a pawn sideways to an empty square
+    if(captured == chess::piece_none && move.from % 8 != move.to % 8 && board.get(move.from).second == chess::piece_pawn)
+    {
+        return chess::piece_pawn;
+    }
+
+    return captured;
+}
+
+
+void generate_captures(const chess::position& state, chess::square en_passant, move_list<chess::move>& output)
+{
+    const chess::board& board = state.get_board();
+    chess::side side = state.get_turn();
+    chess::side other = side == chess::side_white ? chess::side_black : chess::side_white;
+
+    chess::bitboard own = side_set(board, side);
+    chess::bitboard occupied = occupied_set(board);
+    chess::bitboard pawns = board.piece_set(chess::piece_pawn, side);
+    int last_rank = side == chess::side_white ? 7 : 0;
+
+    // every own piece attacking an enemy piece can take it
+    chess::bitboard targets = side_set(board, other) & ~board.piece_set(chess::piece_king, other);
+
+    while(targets)
+    {
+        int to = pop_square(targets);
+        chess::bitboard from_set = attackers(board, static_cast<chess::square>(to), occupied) & own;
+
+        while(from_set)
+        {
+            int from = pop_square(from_set);
+            bool promotion = (pawns & bit(from)) && to / 8 == last_rank;
+            output.push_back(make(from, to, promotion ? chess::piece_queen : chess::piece_none));
+        }
+    }
+
+    // the pawns that could take a pawn on the en passant square are those it attacks as a pawn of the other side
+    if(en_passant != chess::square_none)
+    {
+        chess::bitboard from_set = pawn_attacks(other, en_passant) & pawns;
+
+        while(from_set)
+        {
+            output.push_back(make(pop_square(from_set), en_passant, chess::piece_none));
+        }
+    }
+
+    // pushes to the last rank
+    int forward = side == chess::side_white ? 8 : -8;
+    chess::bitboard promoting = pawns & (side == chess::side_white ? chess::bitboard{0xff} << 48 : chess::bitboard{0xff} << 8);
+
+    while(promoting)
+    {
+        int from = pop_square(promoting);
+
+        if(!(occupied & bit(from + forward)))
+        {
+            output.push_back(make(from, from + forward, chess::piece_queen));
+        }
+    }
+}
+
+
+void generate_quiets(const chess::position& state, move_list<chess::move>& output)
+{
+    const chess::board& board = state.get_board();
+    chess::side side = state.get_turn();
+    chess::side other = side == chess::side_white ? chess::side_black : chess::side_white;
+
+    chess::bitboard occupied = occupied_set(board);
+    chess::bitboard empty = ~occupied;
+    chess::bitboard pawns = board.piece_set(chess::piece_pawn, side);
+    int forward = side == chess::side_white ? 8 : -8;
+    int start_rank = side == chess::side_white ? 1 : 6;
+    int last_rank = side == chess::side_white ? 7 : 0;
+
+    // pawn pushes, and under-promotions by push and by capture
+    chess::bitboard targets = side_set(board, other) & ~board.piece_set(chess::piece_king, other);
+
+    while(pawns)
+    {
+        int from = pop_square(pawns);
+        int to = from + forward;
+
+        if(to / 8 == last_rank)
+        {
+            chess::bitboard promotions = (pawn_attacks(side, static_cast<chess::square>(from)) & targets) | (empty & bit(to));
+
+            while(promotions)
+            {
+                int target = pop_square(promotions);
+
+                for(chess::piece promote: {chess::piece_knight, chess::piece_rook, chess::piece_bishop})
+                {
+                    output.push_back(make(from, target, promote));
+                }
+            }
+        }
+        else if(empty & bit(to))
+        {
+            output.push_back(make(from, to, chess::piece_none));
+
+            if(from / 8 == start_rank && (empty & bit(to + forward)))
+            {
+                output.push_back(make(from, to + forward, chess::piece_none));
+            }
+        }
+    }
+
+    for(chess::piece piece: {chess::piece_knight, chess::piece_bishop, chess::piece_rook, chess::piece_queen, chess::piece_king})
+    {
+        chess::bitboard pieces = board.piece_set(piece, side);
+
+        while(pieces)
+        {
+            chess::square from = static_cast<chess::square>(pop_square(pieces));
+            chess::bitboard attacks = 0;
+
+            switch(piece)
+            {
+            case chess::piece_knight: attacks = knight_attacks(from); break;
+            case chess::piece_bishop: attacks = bishop_attacks(from, occupied); break;
+            case chess::piece_rook: attacks = rook_attacks(from, occupied); break;
+            case chess::piece_queen: attacks = bishop_attacks(from, occupied) | rook_attacks(from, occupied); break;
+            default: attacks = king_attacks(from); break;
+            }
+
+            add_moves(from, attacks & empty, output);
+        }
+    }
+
+    // the king moves two squares towards the rook, which libchess moves along
+    int king = side == chess::side_white ? chess::square_e1 : chess::square_e8;
+
+    if(state.can_castle_kingside(side) && can_castle(board, side, occupied, king, 1))
+    {
+        output.push_back(make(king, king + 2, chess::piece_none));
+    }
+
+    if(state.can_castle_queenside(side) && can_castle(board, side, occupied, king, -1))
+    {
+        output.push_back(make(king, king - 2, chess::piece_none));
+    }
+}
+
+
+bool keeps_king_safe(chess::position& state, const chess::move& move)
+{
+    chess::side side = state.get_turn();
+
+    chess::undo undo = state.make_move(move);
+    bool safe = !king_attacked(state.get_board(), side);
+    state.undo_move(move, undo);
+
+    return safe;
+}
+
+
+bool is_legal(chess::position& state, const chess::move& move)
+{
+    const chess::board& board = state.get_board();
+    chess::side side = state.get_turn();
+    auto [from_side, piece] = board.get(move.from);
+    auto [to_side, captured] = board.get(move.to);
+
+    if(piece == chess::piece_none || from_side != side)
+    {
+        return false;
+    }
+
+    if(captured != chess::piece_none && (to_side == side || captured == chess::piece_king))
+    {
+        return false;
+    }
+
+    chess::bitboard occupied = occupied_set(board);
+    int from = move.from;
+    int to = move.to;
+
+    if(piece == chess::piece_pawn)
+    {
+        int forward = side == chess::side_white ? 8 : -8;
+        bool last_rank = side == chess::side_white ? to / 8 == 7 : to / 8 == 0;
+
+        if(last_rank != (move.promote != chess::piece_none) || move.promote == chess::piece_pawn || move.promote == chess::piece_king)
+        {
+            return false;
+        }
+
+        if(captured == chess::piece_none)
+        {
+            bool start_rank = side == chess::side_white ? from / 8 == 1 : from / 8 == 6;
+
+            // en passant captures are left to the move generator
+            if(to != from + forward && !(start_rank && to == from + 2 * forward && !(occupied & bit(from + forward))))
+            {
+                return false;
+            }
+        }
+        else if(!(pawn_attacks(side, move.from) & bit(to)))
+        {
+            return false;
+        }
+    }
+    else
+    {
+        chess::bitboard targets = 0;
+
+        switch(piece)
+        {
+        case chess::piece_knight: targets = knight_attacks(move.from); break;
+        case chess::piece_bishop: targets = bishop_attacks(move.from, occupied); break;
+        case chess::piece_rook: targets = rook_attacks(move.from, occupied); break;
+        case chess::piece_queen: targets = bishop_attacks(move.from, occupied) | rook_attacks(move.from, occupied); break;
+        // castling is left to the move generator
+        case chess::piece_king: targets = king_attacks(move.from); break;
+        default: break;
+        }
+
+        if(move.promote != chess::piece_none || !(targets & bit(to)))
+        {
+            return false;
+        }
+    }
+
+    return keeps_king_safe(state, move);
+}
+
+
+}
@@ -0,0 +1,56 @@
+#ifndef MOVEGEN_HPP
+#define MOVEGEN_HPP
+
+#include <chess/chess.hpp>
+
+#include "move_list.hpp"
+
+
+namespace search
+{
+
+
+/**
+ * Square the side to move can take en passant on. libchess only exposes it through the FEN, so it is found from the move
+ * that led to the position instead: a double pawn step passes over it.
+ *
+ * @param state     Position after the move
+ * @param previous  Move that led to the position, may be a null move
+ * @return          The square, or chess::square_none
+ */
+chess::square en_passant_square(const chess::position& state, const chess::move& previous);
+
+// Piece a move takes: a pawn for en passant, piece_none if the target square is empty.
+chess::piece captured_piece(const chess::board& board, const chess::move& move);
+
+/**
+ * Captures and queen promotions of the side to move, found from the attack tables without generating the quiet moves.
+ * The moves are pseudo-legal: they may leave the own king in check, which keeps_king_safe tells.
+ * Under-promotions are left to generate_quiets.
+ *
+ * @param state         Position to move in
+ * @param en_passant    En passant square of the position, chess::square_none if there is none
+ * @param output        Moves are appended here
+ */
+void generate_captures(const chess::position& state, chess::square en_passant, move_list<chess::move>& output);
+
+/**
+ * The moves generate_captures leaves out: moves to empty squares, castling and under-promotions, so that the two together
+ * give every legal move. Pseudo-legal like generate_captures, except castling, which is only generated when it is legal.
+ *
+ * @param state     Position to move in
+ * @param output    Moves are appended here
+ */
+void generate_quiets(const chess::position& state, move_list<chess::move>& output);
+
+// True if a pseudo-legal move does not leave the king of the moving side attacked.
+bool keeps_king_safe(chess::position& state, const chess::move& move);
+
+// True if the move could be made in the position, used to check moves that did not come from the move generator.
+bool is_legal(chess::position& state, const chess::move& move);
+
+
+}
+
+
+#endif
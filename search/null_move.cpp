@@ -0,0 +1,30 @@
+#include <bit>
+#include <cstdint>
+
+#include "null_move.hpp"
+#include "values.hpp"
+
+
+namespace search
+{
+
+
+void make_null_move(const chess::position& position, chess::position& null_position)
+{
+    null_position = position;
+    null_position.make_null_move();
+}
+
+
+int non_pawn_material(const chess::board& board, chess::side side)
+{
+    auto material = [&](chess::piece piece)
+    {
+        return piece_value(piece) * std::popcount(static_cast<std::uint64_t>(board.piece_set(piece, side)));
+    };
+
+    return material(chess::piece_knight) + material(chess::piece_bishop) + material(chess::piece_rook) + material(chess::piece_queen);
+}
+
+
+}
@@ -0,0 +1,28 @@
+#ifndef NULL_MOVE_HPP
+#define NULL_MOVE_HPP
+
+#include <chess/chess.hpp>
+
+
+namespace search
+{
+
+
+/**
+ * Position after passing the turn: a copy of the position with the other side to move and no en passant square.
+ * libchess flips both, and the zobrist key with them, in place, so the copy is made into memory the caller keeps
+ * and nothing is allocated. The position passed in is left untouched, so there is nothing to undo.
+ *
+ * @param position          Position to pass in, must not be in check
+ * @param null_position     Receives the position after the null move
+ */
+void make_null_move(const chess::position& position, chess::position& null_position);
+
+// Material of knights, bishops, rooks and queens of a side, in centipawns.
+int non_pawn_material(const chess::board& board, chess::side side);
+
+
+}
+
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef REDUCTIONS_HPP
+#define REDUCTIONS_HPP
+
+#include <array>
+#include <cmath>
+#include <algorithm>
+
+
+namespace search
+{
+
+
+/**
+ * Late move reductions, precomputed as base + log(depth) * log(move number) / divisor plies.
+ */
+class reduction_table
+{
+public:
+    static constexpr int max_index = 64;
+
+    reduction_table()
+    {
+        init(0.75, 2.25);
+    }
+
+    void init(double base, double divisor)
+    {
+        for(int depth = 0; depth < max_index; depth++)
+        {
+            for(int number = 0; number < max_index; number++)
+            {
+                double reduction = depth == 0 || number == 0 ? 0.0 : base + std::log(depth) * std::log(number) / divisor;
+                table[depth][number] = std::max(0, static_cast<int>(reduction));
+            }
+        }
+    }
+
+    // Reduction for the number:th move (counting from 1) searched at depth.
+    int get(int depth, int number) const
+    {
+        return table[std::min(depth, max_index - 1)][std::min(number, max_index - 1)];
+    }
+
+private:
+    std::array<std::array<int, max_index>, max_index> table;
+};
+
+
+}
+
+
+#endif
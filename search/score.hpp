@@ -0,0 +1,83 @@
+#ifndef SCORE_HPP
+#define SCORE_HPP
+
+#include <cstdint>
+
+#include "move_order.hpp"
+
+
+namespace search
+{
+
+
+// Scores are centipawns from the side to move. A mate is scored mate_value minus its distance from the root in plies,
+// so that a shorter mate is preferred, and every score beyond mate_bound is a mate. All scores fit in 16 bits,
+// which is how the transposition table stores them, the search computes in 32 bits so that windows can not overflow.
+using score_t = std::int32_t;
+
+constexpr score_t mate_value = 32000;
+constexpr score_t mate_bound = mate_value - max_ply;
+
+// Tablebase wins rank below every mate and above every evaluation, nearer the root first.
+constexpr score_t tablebase_win = mate_bound - max_ply;
+
+// Every score beyond this is a mate or a tablebase win, both of which count plies from the root.
+constexpr score_t tablebase_win_bound = tablebase_win - max_ply;
+
+// Bound of search windows, above any score.
+constexpr score_t infinite_value = mate_value + 1;
+
+
+// Score of giving mate at ply.
+constexpr score_t mate_in(int ply)
+{
+    return mate_value - ply;
+}
+
+
+// Score of being mated at ply.
+constexpr score_t mated_in(int ply)
+{
+    return -mate_value + ply;
+}
+
+
+// Score of a tablebase win found at ply.
+constexpr score_t tablebase_win_in(int ply)
+{
+    return tablebase_win - ply;
+}
+
+
+constexpr bool is_mate(score_t score)
+{
+    return score >= mate_bound || score <= -mate_bound;
+}
+
+
+// Full moves to mate for UCI, negative if the side to move is getting mated.
+constexpr int mate_moves(score_t score)
+{
+    int plies = mate_value - (score >= 0 ? score : -score);
+    return score >= 0 ? (plies + 1) / 2 : -(plies / 2);
+}
+
+
+// The table stores mates and tablebase wins as distance from the position rather than from the root,
+// since the position can be reached at other plies.
+constexpr score_t score_to_table(score_t score, int ply)
+{
+    return score >= tablebase_win_bound ? score + ply : score <= -tablebase_win_bound ? score - ply : score;
+}
+
+
+constexpr score_t score_from_table(score_t score, int ply)
+{
+    return score >= tablebase_win_bound ? score - ply : score <= -tablebase_win_bound ? score + ply : score;
+}
+
+
+}
+
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef SEARCH_CONTEXT_HPP
+#define SEARCH_CONTEXT_HPP
+
+#include <atomic>
+
+#include <chess/chess.hpp>
+#include <uci/uci.hpp>
+
+#include "thread_data.hpp"
+
+
+namespace search
+{
+
+
+/**
+ * Kind of node a search function is compiled for. PV nodes are searched with an open window and keep the principal
+ * variation, all other nodes only have to prove that they are above or below a null window, so their PV work is compiled out.
+ * The root is searched by its own function.
+ */
+enum class node_type
+{
+    pv,
+    non_pv
+};
+
+
+// What every node of one thread's search works on, passed down as a single reference.
+struct search_context
+{
+    thread_data& thread;
+    chess::position& state;
+    uci::search_info& info;
+    const std::atomic_bool& stop;
+};
+
+
+}
+
+
+#endif
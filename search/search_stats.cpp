@@ -0,0 +1,146 @@
+#include <iomanip>
+#include <sstream>
+
+#include "search_stats.hpp"
+
+
+namespace search
+{
+
+
+namespace
+{
+
+// Percentage of part in total, 0 without a total.
+double percent(unsigned long long part, unsigned long long total)
+{
+    return total > 0 ? 100.0 * part / total : 0.0;
+}
+
+double average(unsigned long long sum, unsigned long long count)
+{
+    return count > 0 ? static_cast<double>(sum) / count : 0.0;
+}
+
+// Nodes and seconds spent on iteration i alone, the recorded totals include the earlier iterations.
+unsigned long long iteration_nodes(const search_stats& stats, int i)
+{
+    return stats.iterations[i].nodes - (i > 0 ? stats.iterations[i - 1].nodes : 0);
+}
+
+double iteration_seconds(const search_stats& stats, int i)
+{
+    return stats.iterations[i].seconds - (i > 0 ? stats.iterations[i - 1].seconds : 0.0);
+}
+
+// Nodes of an iteration over the nodes of the one before it.
+double branching_factor(const search_stats& stats, int i)
+{
+    return i > 0 ? average(iteration_nodes(stats, i), iteration_nodes(stats, i - 1)) : 0.0;
+}
+
+}
+
+
+void search_stats::clear()
+{
+    *this = search_stats();
+}
+
+
+void search_stats::add_iteration(int depth, unsigned long long total_nodes, double elapsed_seconds)
+{
+    if(iteration_count < max_ply)
+    {
+        iterations[iteration_count++] = {depth, total_nodes, elapsed_seconds};
+    }
+}
+
+
+search_stats& search_stats::operator+=(const search_stats& other)
+{
+    nodes += other.nodes;
+    qnodes += other.qnodes;
+    tt_probes += other.tt_probes;
+    tt_hits += other.tt_hits;
+    tt_cutoffs += other.tt_cutoffs;
+    fail_highs += other.fail_highs;
+    first_move_fail_highs += other.first_move_fail_highs;
+    cutoff_index_sum += other.cutoff_index_sum;
+    null_tries += other.null_tries;
+    null_cutoffs += other.null_cutoffs;
+    lmr_tries += other.lmr_tries;
+    lmr_successes += other.lmr_successes;
+
+    return *this;
+}
+
+
+std::string search_stats::to_string() const
+{
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1)
+        << "search stats nodes " << nodes
+        << " qnodes " << qnodes
+        << " tt probes " << tt_probes
+        << " hits " << percent(tt_hits, tt_probes) << "%"
+        << " cutoffs " << percent(tt_cutoffs, tt_probes) << "%"
+        << " fail high first " << percent(first_move_fail_highs, fail_highs) << "%"
+        << " cutoff index " << std::setprecision(2) << average(cutoff_index_sum, fail_highs) << std::setprecision(1)
+        << " null " << null_tries << " success " << percent(null_cutoffs, null_tries) << "%"
+        << " lmr " << lmr_tries << " success " << percent(lmr_successes, lmr_tries) << "%";
+
+    return out.str();
+}
+
+
+std::string search_stats::iterations_to_string() const
+{
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(2) << "iterations";
+
+    for(int i = 0; i < iteration_count; i++)
+    {
+        out << " depth " << iterations[i].depth
+            << " nodes " << iteration_nodes(*this, i)
+            << " ebf " << branching_factor(*this, i)
+            << " ms " << static_cast<long long>(iteration_seconds(*this, i) * 1000);
+    }
+
+    return out.str();
+}
+
+
+std::string search_stats::to_json() const
+{
+    std::ostringstream out;
+    out << "{\"nodes\":" << nodes
+        << ",\"qnodes\":" << qnodes
+        << ",\"tt_probes\":" << tt_probes
+        << ",\"tt_hits\":" << tt_hits
+        << ",\"tt_cutoffs\":" << tt_cutoffs
+        << ",\"fail_highs\":" << fail_highs
+        << ",\"first_move_fail_highs\":" << first_move_fail_highs
+        << ",\"average_cutoff_index\":" << average(cutoff_index_sum, fail_highs)
+        << ",\"null_tries\":" << null_tries
+        << ",\"null_cutoffs\":" << null_cutoffs
+        << ",\"lmr_tries\":" << lmr_tries
+        << ",\"lmr_successes\":" << lmr_successes
+        << ",\"iterations\":[";
+
+    for(int i = 0; i < iteration_count; i++)
+    {
+        out << (i > 0 ? "," : "")
+            << "{\"depth\":" << iterations[i].depth
+            << ",\"nodes\":" << iteration_nodes(*this, i)
+            << ",\"ebf\":" << branching_factor(*this, i)
+            << ",\"ms\":" << static_cast<long long>(iteration_seconds(*this, i) * 1000) << "}";
+    }
+
+    out << "]}";
+
+    return out.str();
+}
+
+
+}
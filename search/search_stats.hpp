@@ -0,0 +1,74 @@
+#ifndef SEARCH_STATS_HPP
+#define SEARCH_STATS_HPP
+
+#include <array>
+#include <string>
+
+#include "move_order.hpp"
+
+
+namespace search
+{
+
+
+// Totals at the end of a finished iteration of the main thread.
+struct iteration_stats
+{
+    int depth = 0;
+    unsigned long long nodes = 0;
+    double seconds = 0.0;
+};
+
+
+/**
+ * Counters of the work done by a search. Each thread counts in its own plain integers, so counting costs
+ * no more than an increment, and the totals are added up once the threads are done.
+ */
+struct search_stats
+{
+    // All nodes and the quiescence nodes among them.
+    unsigned long long nodes = 0;
+    unsigned long long qnodes = 0;
+
+    // Transposition table lookups, those that found the position, and those whose score ended the node.
+    unsigned long long tt_probes = 0;
+    unsigned long long tt_hits = 0;
+    unsigned long long tt_cutoffs = 0;
+
+    // Beta cutoffs, how many came from the first move, and the sum of the indices of the moves that caused them.
+    unsigned long long fail_highs = 0;
+    unsigned long long first_move_fail_highs = 0;
+    unsigned long long cutoff_index_sum = 0;
+
+    // Null move searches and those that cut the node off.
+    unsigned long long null_tries = 0;
+    unsigned long long null_cutoffs = 0;
+
+    // Reduced searches and those that failed low as expected, needing no full depth search.
+    unsigned long long lmr_tries = 0;
+    unsigned long long lmr_successes = 0;
+
+    std::array<iteration_stats, max_ply> iterations{};
+    int iteration_count = 0;
+
+    void clear();
+
+    void add_iteration(int depth, unsigned long long total_nodes, double elapsed_seconds);
+
+    // Adds the counters of another thread. Iterations are only recorded by the main thread and are not added.
+    search_stats& operator+=(const search_stats& other);
+
+    std::string to_string() const;
+
+    // Effective branching factor and time of each iteration.
+    std::string iterations_to_string() const;
+
+    // Everything on one line of JSON, for scripts.
+    std::string to_json() const;
+};
+
+
+}
+
+
+#endif
@@ -0,0 +1,221 @@
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+
+#include "see.hpp"
+#include "attack.hpp"
+#include "movegen.hpp"
+#include "values.hpp"
+
+
+namespace search
+{
+
+
+namespace
+{
+
+// Least valuable first, the king last since it can only take when the other side has no attackers left.
+constexpr std::array<chess::piece, 6> exchange_order = {
+    chess::piece_pawn, chess::piece_knight, chess::piece_bishop, chess::piece_rook, chess::piece_queen, chess::piece_king
+};
+
+chess::side other_side(chess::side side)
+{
+    return side == chess::side_white ? chess::side_black : chess::side_white;
+}
+
+chess::bitboard lowest(chess::bitboard set)
+{
+    return set & (~set + 1);
+}
+
+// Everything about the target square that changes while pieces are taken off the board.
+struct exchange
+{
+    const chess::board& board;
+    chess::square target;
+    chess::bitboard occupied;
+    chess::bitboard attacking;
+    chess::bitboard diagonal;
+    chess::bitboard straight;
+
+    exchange(const chess::board& board, chess::square target, chess::bitboard occupied):
+    board(board), target(target), occupied(occupied), attacking(attackers(board, target, occupied))
+    {
+        chess::bitboard queens = board.piece_set(chess::piece_queen, chess::side_white) | board.piece_set(chess::piece_queen, chess::side_black);
+        diagonal = board.piece_set(chess::piece_bishop, chess::side_white) | board.piece_set(chess::piece_bishop, chess::side_black) | queens;
+        straight = board.piece_set(chess::piece_rook, chess::side_white) | board.piece_set(chess::piece_rook, chess::side_black) | queens;
+    }
+
+    // Take a piece off the board and add the sliders it was hiding.
+    void remove(chess::bitboard square)
+    {
+        occupied ^= square;
+        attacking = (attacking | (bishop_attacks(target, occupied) & diagonal) | (rook_attacks(target, occupied) & straight)) & occupied;
+    }
+
+    // Least valuable attacker of a side, false if it has none.
+    bool least_valuable(chess::side side, chess::bitboard& square, chess::piece& piece) const
+    {
+        chess::bitboard own = attacking & side_set(board, side);
+
+        if(own == 0)
+        {
+            return false;
+        }
+
+        for(chess::piece candidate: exchange_order)
+        {
+            chess::bitboard set = own & board.piece_set(candidate, side);
+
+            if(set)
+            {
+                square = lowest(set);
+                piece = candidate;
+                return true;
+            }
+        }
+
+        return false;
+    }
+};
+
+// Value taken by the move itself, en passant captures a pawn that is not on the target square.
+int captured_value(const chess::board& board, const chess::move& move)
+{
+    int value = piece_value(captured_piece(board, move));
+
+    if(move.promote != chess::piece_none)
+    {
+        value += piece_value(move.promote) - piece_value(chess::piece_pawn);
+    }
+
+    return value;
+}
+
+}
+
+
+int see(const chess::position& state, const chess::move& move)
+{
+    const chess::board& board = state.get_board();
+    chess::bitboard from = chess::bitboard{1} << move.from;
+
+    exchange swaps(board, move.to, occupied_set(board));
+    chess::piece on_target = move.promote != chess::piece_none ? move.promote : board.get(move.from).second;
+    chess::side side = state.get_turn();
+
+    // gain[d] is the material won by the side making the d:th capture, if the exchange stopped right after it
+    std::array<int, 32> gain;
+    int d = 0;
+    gain[0] = captured_value(board, move);
+    swaps.remove(from);
+
+    chess::bitboard square;
+    chess::piece piece;
+
+    while(d + 1 < static_cast<int>(gain.size()))
+    {
+        side = other_side(side);
+
+        if(!swaps.least_valuable(side, square, piece))
+        {
+            break;
+        }
+
+        // the king may not take into a defended square
+        if(piece == chess::piece_king && (swaps.attacking & ~square & side_set(board, other_side(side))))
+        {
+            break;
+        }
+
+        d++;
+        gain[d] = piece_value(on_target) - gain[d - 1];
+
+        // neither side can do better by continuing
+        if(std::max(-gain[d - 1], gain[d]) < 0)
+        {
+            break;
+        }
+
+        swaps.remove(square);
+        on_target = piece;
+    }
+
+    // each side stops capturing when that is better for it
+    while(d > 0)
+    {
+        gain[d - 1] = -std::max(-gain[d - 1], gain[d]);
+        d--;
+    }
+
+    return gain[0];
+}
+
+
+bool see_ge(const chess::position& state, const chess::move& move, int threshold)
+{
+    const chess::board& board = state.get_board();
+
+    // what the side to move is short of the threshold if the exchange stops now
+    int swap = captured_value(board, move) - threshold;
+
+    if(swap < 0)
+    {
+        return false;
+    }
+
+    chess::piece on_target = move.promote != chess::piece_none ? move.promote : board.get(move.from).second;
+
+    // even losing the moving piece for nothing keeps the threshold
+    swap = piece_value(on_target) - swap;
+
+    if(swap <= 0)
+    {
+        return true;
+    }
+
+    exchange swaps(board, move.to, occupied_set(board));
+    swaps.remove(chess::bitboard{1} << move.from);
+
+    chess::side side = state.get_turn();
+    chess::bitboard square;
+    chess::piece piece;
+
+    // result flips with every capture, 1 while the side to move is ahead
+    int result = 1;
+
+    while(true)
+    {
+        side = other_side(side);
+
+        if(!swaps.least_valuable(side, square, piece))
+        {
+            break;
+        }
+
+        result ^= 1;
+
+        // the king may only take when the other side has no attackers left
+        if(piece == chess::piece_king)
+        {
+            return (swaps.attacking & side_set(board, other_side(side))) ? result ^ 1 : result;
+        }
+
+        swap = piece_value(piece) - swap;
+
+        if(swap < result)
+        {
+            break;
+        }
+
+        swaps.remove(square);
+    }
+
+    return result;
+}
+
+
+}
@@ -0,0 +1,30 @@
+#ifndef SEE_HPP
+#define SEE_HPP
+
+#include <chess/chess.hpp>
+
+
+namespace search
+{
+
+
+/**
+ * Static exchange evaluation: material won by the side to move if both sides keep capturing on the target
+ * square of the move with their least valuable piece, and may stop whenever continuing would lose material.
+ * Sliders behind other attackers (x-rays) join the exchange once the squares in front of them are cleared.
+ * Pins are ignored.
+ *
+ * @param state Position before the move
+ * @param move  Capture, promotion or quiet move
+ * @return      Material gain in centipawns
+ */
+int see(const chess::position& state, const chess::move& move);
+
+// True if see(state, move) >= threshold, without building the whole exchange when it is decided early.
+bool see_ge(const chess::position& state, const chess::move& move, int threshold);
+
+
+}
+
+
+#endif
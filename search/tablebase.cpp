@@ -0,0 +1,211 @@
+#include <bit>
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+#include "tablebase.hpp"
+#include "movegen.hpp"
+
+#ifdef HAS_FATHOM
+#include <tbprobe.h>
+#endif
+
+
+namespace search
+{
+
+
+#ifdef HAS_FATHOM
+
+namespace
+{
+
+// Position in the form Fathom probes, castling rights are 0 since the tables have none.
+struct fathom_position
+{
+    std::uint64_t white;
+    std::uint64_t black;
+    std::uint64_t kings;
+    std::uint64_t queens;
+    std::uint64_t rooks;
+    std::uint64_t bishops;
+    std::uint64_t knights;
+    std::uint64_t pawns;
+    unsigned rule50;
+    unsigned en_passant;
+    bool white_to_move;
+};
+
+std::uint64_t piece_set(const chess::board& board, chess::piece piece)
+{
+    return board.piece_set(piece, chess::side_white) | board.piece_set(piece, chess::side_black);
+}
+
+std::uint64_t side_set(const chess::board& board, chess::side side)
+{
+    std::uint64_t result = 0;
+
+    for(chess::piece piece: {chess::piece_pawn, chess::piece_knight, chess::piece_bishop, chess::piece_rook, chess::piece_queen, chess::piece_king})
+    {
+        result |= board.piece_set(piece, side);
+    }
+
+    return result;
+}
+
+// False for positions the tables do not hold: too many pieces or castling rights.
+bool to_fathom(const chess::position& position, unsigned en_passant, fathom_position& result)
+{
+    const chess::board& board = position.get_board();
+
+    result.white = side_set(board, chess::side_white);
+    result.black = side_set(board, chess::side_black);
+
+    if(std::popcount(result.white | result.black) > static_cast<int>(TB_LARGEST))
+    {
+        return false;
+    }
+
+    for(chess::side side: {chess::side_white, chess::side_black})
+    {
+        if(position.can_castle_kingside(side) || position.can_castle_queenside(side))
+        {
+            return false;
+        }
+    }
+
+    result.kings = piece_set(board, chess::piece_king);
+    result.queens = piece_set(board, chess::piece_queen);
+    result.rooks = piece_set(board, chess::piece_rook);
+    result.bishops = piece_set(board, chess::piece_bishop);
+    result.knights = piece_set(board, chess::piece_knight);
+    result.pawns = piece_set(board, chess::piece_pawn);
+    result.rule50 = position.get_halfmove_clock();
+    result.white_to_move = position.get_turn() == chess::side_white;
+    result.en_passant = en_passant;
+
+    return true;
+}
+
+// En passant square for Fathom, 0 (a1, never an en passant square) if there is none.
+unsigned fathom_en_passant(const chess::position& position, const chess::move& previous)
+{
+    chess::square square = en_passant_square(position, previous);
+
+    return square == chess::square_none ? 0 : static_cast<unsigned>(square);
+}
+
+// The same from the en passant field of the FEN, for positions whose previous move is not known.
+unsigned fathom_en_passant(const chess::position& position)
+{
+    // Only a double pawn step leaves an en passant square, and it resets the clock
+    if(position.get_halfmove_clock() != 0)
+    {
+        return 0;
+    }
+
+    // fen fields: placement, side, castling, en passant
+    std::istringstream in(position.to_fen());
+    std::string placement, turn, castling, en_passant;
+    in >> placement >> turn >> castling >> en_passant;
+
+    return en_passant == "-" ? 0 : (en_passant[1] - '1') * 8 + (en_passant[0] - 'a');
+}
+
+}
+
+
+int tablebase_init(const std::string& path)
+{
+    tb_free();
+
+    if(path.empty() || !tb_init(path.c_str()))
+    {
+        return 0;
+    }
+
+    return static_cast<int>(TB_LARGEST);
+}
+
+
+int tablebase_pieces()
+{
+    return static_cast<int>(TB_LARGEST);
+}
+
+
+std::optional<wdl> probe_wdl(const chess::position& position, const chess::move& previous)
+{
+    fathom_position p;
+
+    if(!to_fathom(position, fathom_en_passant(position, previous), p))
+    {
+        return std::nullopt;
+    }
+
+    unsigned result = tb_probe_wdl(p.white, p.black, p.kings, p.queens, p.rooks, p.bishops, p.knights, p.pawns,
+                                   p.rule50, 0, p.en_passant, p.white_to_move);
+
+    if(result == TB_RESULT_FAILED)
+    {
+        return std::nullopt;
+    }
+
+    return static_cast<wdl>(result);
+}
+
+
+std::optional<chess::move> probe_root(const chess::position& position, wdl& result)
+{
+    fathom_position p;
+
+    if(!to_fathom(position, fathom_en_passant(position), p))
+    {
+        return std::nullopt;
+    }
+
+    unsigned root = tb_probe_root(p.white, p.black, p.kings, p.queens, p.rooks, p.bishops, p.knights, p.pawns,
+                                  p.rule50, 0, p.en_passant, p.white_to_move, nullptr);
+
+    if(root == TB_RESULT_FAILED || root == TB_RESULT_CHECKMATE || root == TB_RESULT_STALEMATE)
+    {
+        return std::nullopt;
+    }
+
+    constexpr chess::piece promotions[] = {chess::piece_none, chess::piece_queen, chess::piece_rook, chess::piece_bishop, chess::piece_knight};
+
+    result = static_cast<wdl>(TB_GET_WDL(root));
+
+    return chess::move(static_cast<chess::square>(TB_GET_FROM(root)), static_cast<chess::square>(TB_GET_TO(root)),
+                       promotions[TB_GET_PROMOTES(root)]);
+}
+
+#else
+
+int tablebase_init(const std::string&)
+{
+    return 0;
+}
+
+
+int tablebase_pieces()
+{
+    return 0;
+}
+
+
+std::optional<wdl> probe_wdl(const chess::position&, const chess::move&)
+{
+    return std::nullopt;
+}
+
+
+std::optional<chess::move> probe_root(const chess::position&, wdl&)
+{
+    return std::nullopt;
+}
+
+#endif
+
+
+}
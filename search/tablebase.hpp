@@ -0,0 +1,57 @@
+#ifndef TABLEBASE_HPP
+#define TABLEBASE_HPP
+
+#include <optional>
+#include <string>
+
+#include <chess/chess.hpp>
+
+
+namespace search
+{
+
+
+// Result of a tablebase position for the side to move. Cursed wins and blessed losses are draws under the fifty-move rule.
+enum class wdl
+{
+    loss,
+    blessed_loss,
+    draw,
+    cursed_win,
+    win
+};
+
+
+/**
+ * Loads the Syzygy tables in the directories of path, separated by ':' like the SyzygyPath option of other engines.
+ * An empty path unloads them. The files are memory mapped read-only as they are needed.
+ * Probing needs the Fathom library, a build without it never has tables.
+ *
+ * @return  Most pieces of a loaded table, 0 if there are none
+ */
+int tablebase_init(const std::string& path);
+
+// Most pieces of a loaded table, 0 if there are none.
+int tablebase_pieces();
+
+/**
+ * Win, draw or loss of a position with at most tablebase_pieces() pieces.
+ * Tables only answer right after a capture or pawn move and without castling rights, otherwise nothing is returned.
+ *
+ * @param position  Position to probe
+ * @param previous  Move that led to the position, may be a null move. A double pawn step gives the en passant square,
+ *                  which libchess only exposes through the FEN.
+ */
+std::optional<wdl> probe_wdl(const chess::position& position, const chess::move& previous);
+
+/**
+ * Move of the root that keeps the best result and reaches it fastest by distance to zeroing (DTZ), so that a win
+ * is converted within the fifty-move rule. The result of the position is written to result.
+ */
+std::optional<chess::move> probe_root(const chess::position& position, wdl& result);
+
+
+}
+
+
+#endif
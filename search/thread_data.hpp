@@ -0,0 +1,105 @@
+#ifndef THREAD_DATA_HPP
+#define THREAD_DATA_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <random>
+#include <vector>
+
+#include <chess/chess.hpp>
+
+#include "hash_history.hpp"
+#include "move_list.hpp"
+#include "move_order.hpp"
+#include "move_picker.hpp"
+#include "score.hpp"
+#include "search_stats.hpp"
+
+
+namespace search
+{
+
+
+/**
+ * Everything a search thread changes while searching. With Lazy SMP the threads search the same root
+ * independently and only share the transposition table, so each one keeps its own ordering heuristics.
+ */
+struct thread_data
+{
+    // 0 for the main thread, which reports progress and decides the move.
+    int id = 0;
+
+    move_order order;
+    search::picker_stats picker_stats;
+    search_stats stats;
+
+    // Moves leading from the root to the current node, indexed by ply.
+    std::array<chess::move, max_ply> current_line{};
+
+    // Memory of the nodes at each ply, reused from node to node so that the search does not allocate.
+    struct stack_entry
+    {
+        picker_buffers picker;
+        move_list<chess::move> quiets_tried;
+
+        // Evaluation of the node before searching it, -infinite_value in check.
+        score_t static_eval = -infinite_value;
+
+        // Position after a null move at this ply, searched in place of the node's own position.
+        chess::position null_position;
+    };
+
+    std::array<stack_entry, max_ply> stack;
+
+    // Positions from the game and the current search path, for repetition detection.
+    // Quiescence only plays captures and evasions, so it neither pushes nor checks positions.
+    hash_history history;
+
+    // Written by the owning thread only, read by the main thread for reporting.
+    std::atomic<unsigned long long> nodes = 0;
+
+    // Heap allocations made below the root, where the search must make none. Only counted in debug builds, see allocation_count.
+    unsigned long long tree_allocations = 0;
+
+    // Perturbs the root move order of helper threads.
+    std::mt19937 random;
+
+    // Triangular principal variation table: pv[ply] holds the best line from ply onwards, up to pv_length[ply].
+    std::array<std::array<chess::move, max_ply>, max_ply> pv;
+    std::array<int, max_ply> pv_length{};
+
+    // Deepest ply reached in the current iteration.
+    int seldepth = 0;
+
+    // With a single writer a relaxed load and store is enough, a locked increment at every node is not needed.
+    void count_node()
+    {
+        nodes.store(nodes.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    // Move became the best at ply, its line continues with the best line of the child.
+    void update_pv(int ply, const chess::move& move)
+    {
+        pv[ply][ply] = move;
+
+        for(int i = ply + 1; i < pv_length[ply + 1]; i++)
+        {
+            pv[ply][i] = pv[ply + 1][i];
+        }
+
+        pv_length[ply] = std::max(pv_length[ply + 1], ply + 1);
+    }
+
+    // Best line from the root.
+    std::vector<chess::move> principal_variation() const
+    {
+        return std::vector<chess::move>(pv[0].begin(), pv[0].begin() + pv_length[0]);
+    }
+};
+
+
+}
+
+
+#endif
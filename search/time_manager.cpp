@@ -0,0 +1,150 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "time_manager.hpp"
+#include "transposition_table.hpp"
+
+
+namespace search
+{
+
+
+time_manager::time_manager(unsigned long long poll_interval):
+poll_interval(poll_interval),
+next_poll(poll_interval),
+start_time(std::chrono::steady_clock::now()),
+planned(std::numeric_limits<double>::infinity()),
+soft(std::numeric_limits<double>::infinity()),
+hard(std::numeric_limits<double>::infinity()),
+out_of_time(false),
+best(),
+stable_iterations(0),
+iteration_start(0.0),
+last_iteration(0.0),
+previous_iteration(0.0)
+{
+
+}
+
+
+void time_manager::start(const uci::search_limit& limit, chess::side side, double overhead)
+{
+    start_time = std::chrono::steady_clock::now();
+    next_poll = poll_interval;
+    out_of_time = false;
+
+    best = chess::move();
+    stable_iterations = 0;
+    iteration_start = 0.0;
+    last_iteration = 0.0;
+    previous_iteration = 0.0;
+
+    soft = std::numeric_limits<double>::infinity();
+    hard = std::numeric_limits<double>::infinity();
+
+    double clock = limit.clocks[side];
+    double increment = limit.increments[side];
+
+    if(std::isfinite(clock))
+    {
+        int moves_to_go = limit.remaining_moves ? std::clamp(*limit.remaining_moves, 1, default_moves_to_go) : default_moves_to_go;
+
+        // the increments of the coming moves can be spent now, the overhead of every one of them can not
+        double available = std::max(0.0, clock + increment * (moves_to_go - 1) - overhead * moves_to_go);
+
+        soft = available / moves_to_go;
+        hard = std::max(0.0, std::min(soft * max_share_factor, clock * max_clock_share - overhead));
+        soft = std::min(soft, hard);
+    }
+
+    if(std::isfinite(limit.time))
+    {
+        double time = std::max(0.0, limit.time - overhead);
+        soft = std::min(soft, time);
+        hard = std::min(hard, time);
+    }
+
+    // a fixed move time is used as given, only clock based limits adapt to the search
+    planned = std::isfinite(clock) && !std::isfinite(limit.time) ? soft : std::numeric_limits<double>::infinity();
+}
+
+
+void time_manager::iteration_done(const chess::move& best_move)
+{
+    double now = elapsed();
+    previous_iteration = last_iteration;
+    last_iteration = now - iteration_start;
+    iteration_start = now;
+
+    bool changed = pack_move(best) != 0 && !same_move(best, best_move);
+    stable_iterations = same_move(best, best_move) ? stable_iterations + 1 : 0;
+    best = best_move;
+
+    if(!std::isfinite(planned))
+    {
+        return;
+    }
+
+    // a new best move means the search has not settled, a best move that survives deeper searches needs less time
+    double factor = changed ? unstable_factor : std::max(min_stable_factor, 1.0 - stable_step * stable_iterations);
+    soft = std::min(planned * factor, hard);
+}
+
+
+bool time_manager::can_start_iteration() const
+{
+    if(!std::isfinite(soft))
+    {
+        return true;
+    }
+
+    // the next iteration is assumed to grow like the last one did
+    double growth = previous_iteration > 0.0 ? std::clamp(last_iteration / previous_iteration, 1.5, 8.0) : 3.0;
+
+    return elapsed() + last_iteration * growth <= soft;
+}
+
+
+void time_manager::poll(unsigned long long nodes)
+{
+    if(nodes < next_poll)
+    {
+        return;
+    }
+
+    next_poll = nodes + poll_interval;
+
+    if(elapsed() >= hard)
+    {
+        out_of_time = true;
+    }
+}
+
+
+bool time_manager::expired() const
+{
+    return out_of_time;
+}
+
+
+double time_manager::elapsed() const
+{
+    std::chrono::duration<double> elapsed_time = std::chrono::steady_clock::now() - start_time;
+    return elapsed_time.count();
+}
+
+
+double time_manager::soft_limit() const
+{
+    return soft;
+}
+
+
+double time_manager::hard_limit() const
+{
+    return hard;
+}
+
+
+}
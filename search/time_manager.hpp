@@ -0,0 +1,88 @@
+#ifndef TIME_MANAGER_HPP
+#define TIME_MANAGER_HPP
+
+#include <atomic>
+#include <chrono>
+
+#include <chess/chess.hpp>
+#include <uci/uci.hpp>
+
+
+namespace search
+{
+
+
+/**
+ * Decides how long a search may take.
+ *
+ * The soft limit is the time the search aims for. It is checked between iterations only: an iteration is not
+ * started if it is predicted to end past the soft limit, and the limit grows when the best move changes and
+ * shrinks while it stays the same. The hard limit stops the search wherever it is.
+ */
+class time_manager
+{
+public:
+    // Clock is read every poll_interval nodes of the main thread.
+    time_manager(unsigned long long poll_interval);
+
+    /**
+     * Plans the time of a new search.
+     *
+     * @param limit     Limits of the go command, uses the clock, increment, moves to go and move time
+     * @param side      Side to move
+     * @param overhead  Time lost per move outside the engine, in seconds
+     */
+    void start(const uci::search_limit& limit, chess::side side, double overhead);
+
+    // Called by the main thread after every finished iteration.
+    void iteration_done(const chess::move& best_move);
+
+    // True if the next iteration is expected to end before the soft limit.
+    bool can_start_iteration() const;
+
+    // Checks the hard limit if enough nodes were searched since the last check. Main thread only.
+    void poll(unsigned long long nodes);
+
+    // True once the hard limit has passed, may be called from any thread.
+    bool expired() const;
+
+    // Seconds since start.
+    double elapsed() const;
+
+    double soft_limit() const;
+    double hard_limit() const;
+
+private:
+    // Moves the remaining clock is split over when the GUI does not say.
+    static constexpr int default_moves_to_go = 30;
+
+    // A single move may take this many times its share of the clock, but never more than max_clock_share of it.
+    static constexpr double max_share_factor = 4.0;
+    static constexpr double max_clock_share = 0.8;
+
+    // Soft limit scaling for an unstable best move, and per iteration the best move stays the same.
+    static constexpr double unstable_factor = 1.6;
+    static constexpr double stable_step = 0.1;
+    static constexpr double min_stable_factor = 0.5;
+
+    unsigned long long poll_interval;
+    unsigned long long next_poll;
+
+    std::chrono::steady_clock::time_point start_time;
+    double planned;
+    double soft;
+    double hard;
+    std::atomic_bool out_of_time;
+
+    chess::move best;
+    int stable_iterations;
+    double iteration_start;
+    double last_iteration;
+    double previous_iteration;
+};
+
+
+}
+
+
+#endif
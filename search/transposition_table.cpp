@@ -0,0 +1,169 @@
+#include <algorithm>
+
+#include "transposition_table.hpp"
+
+
+namespace search
+{
+
+
+namespace
+{
+
+// score in the low 16 bits, then move, depth and bound
+std::uint64_t pack_entry(std::int16_t score, std::uint16_t move, std::int16_t depth, bound type)
+{
+    return static_cast<std::uint64_t>(static_cast<std::uint16_t>(score))
+        | static_cast<std::uint64_t>(move) << 16
+        | static_cast<std::uint64_t>(static_cast<std::uint16_t>(depth)) << 32
+        | static_cast<std::uint64_t>(type) << 48;
+}
+
+bound entry_type(std::uint64_t data)
+{
+    return static_cast<bound>(static_cast<std::uint8_t>(data >> 48));
+}
+
+tt_entry unpack_entry(std::uint64_t key, std::uint64_t data)
+{
+    return tt_entry{
+        key,
+        static_cast<std::int16_t>(static_cast<std::uint16_t>(data)),
+        static_cast<std::uint16_t>(data >> 16),
+        static_cast<std::int16_t>(static_cast<std::uint16_t>(data >> 32)),
+        entry_type(data)
+    };
+}
+
+}
+
+
+transposition_table::transposition_table(std::size_t megabytes):
+slots(),
+count{0},
+mask{0},
+size_mb{0}
+{
+    resize(megabytes);
+}
+
+
+void transposition_table::resize(std::size_t megabytes)
+{
+    // largest power of two number of slots that fits
+    count = 1;
+    while(2 * count * sizeof(slot) <= megabytes * 1024 * 1024)
+    {
+        count *= 2;
+    }
+
+    slots = std::make_unique<slot[]>(count);
+    mask = count - 1;
+    size_mb = megabytes;
+}
+
+
+void transposition_table::clear()
+{
+    for(std::size_t i = 0; i < count; i++)
+    {
+        slots[i].check.store(0, std::memory_order_relaxed);
+        slots[i].data.store(0, std::memory_order_relaxed);
+    }
+}
+
+
+bool transposition_table::probe(std::uint64_t key, tt_entry& entry) const
+{
+    const slot& target = slots[key & mask];
+    std::uint64_t data = target.data.load(std::memory_order_relaxed);
+    std::uint64_t check = target.check.load(std::memory_order_relaxed);
+
+    if((check ^ data) != key)
+    {
+        return false;
+    }
+
+    entry = unpack_entry(key, data);
+    return entry.type != bound::none;
+}
+
+
+void transposition_table::store(std::uint64_t key, int depth, bound type, score_t score, const chess::move& move)
+{
+    slot& target = slots[key & mask];
+
+    tt_entry old;
+    bool same = probe(key, old);
+
+    if(same && depth < old.depth && type != bound::exact)
+    {
+        return;
+    }
+
+    std::uint16_t packed = pack_move(move);
+
+    // keep the old best move if this search did not produce one
+    if(same && packed == 0)
+    {
+        packed = old.move;
+    }
+
+    std::int16_t stored = static_cast<std::int16_t>(std::clamp(score, -infinite_value, infinite_value));
+    std::uint64_t data = pack_entry(stored, packed, static_cast<std::int16_t>(std::max(depth, 0)), type);
+    target.data.store(data, std::memory_order_relaxed);
+    target.check.store(key ^ data, std::memory_order_relaxed);
+}
+
+
+std::size_t transposition_table::megabytes() const
+{
+    return size_mb;
+}
+
+
+int transposition_table::hashfull() const
+{
+    std::size_t sample = std::min<std::size_t>(1000, count);
+    std::size_t used = 0;
+
+    for(std::size_t i = 0; i < sample; i++)
+    {
+        if(entry_type(slots[i].data.load(std::memory_order_relaxed)) != bound::none)
+        {
+            used++;
+        }
+    }
+
+    return static_cast<int>(used * 1000 / sample);
+}
+
+
+std::uint16_t pack_move(const chess::move& move)
+{
+    if(move.from == move.to)
+    {
+        return 0;
+    }
+
+    return static_cast<std::uint16_t>(move.from | move.to << 6 | move.promote << 12);
+}
+
+
+chess::move unpack_move(std::uint16_t packed)
+{
+    chess::square from = static_cast<chess::square>(packed & 63);
+    chess::square to = static_cast<chess::square>((packed >> 6) & 63);
+    chess::piece promote = static_cast<chess::piece>((packed >> 12) & 7);
+
+    return chess::move{from, to, promote};
+}
+
+
+bool same_move(const chess::move& a, const chess::move& b)
+{
+    return pack_move(a) == pack_move(b);
+}
+
+
+}
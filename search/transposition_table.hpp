@@ -0,0 +1,93 @@
+#ifndef TRANSPOSITION_TABLE_HPP
+#define TRANSPOSITION_TABLE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+
+#include <chess/chess.hpp>
+
+#include "score.hpp"
+
+
+namespace search
+{
+
+
+// How the stored score relates to the true value of the position.
+enum class bound: std::uint8_t
+{
+    none,
+    exact,
+    lower,
+    upper
+};
+
+
+// Contents of a table slot. Scores are stored from the perspective of the side to move.
+struct tt_entry
+{
+    std::uint64_t key;
+    std::int16_t score;
+    std::uint16_t move;
+    std::int16_t depth;
+    bound type;
+};
+
+
+/**
+ * Fixed size hash table of searched positions, shared between iterations, moves and search threads.
+ * Threads read and write slots without locking. A slot stores its data and the key xor the data, so the whole key
+ * is verified, and a slot torn by two threads writing at once does not verify and reads as empty.
+ */
+class transposition_table
+{
+public:
+    transposition_table(std::size_t megabytes);
+
+    // Reallocate table to given size. All entries are lost.
+    void resize(std::size_t megabytes);
+
+    // Forget all entries.
+    void clear();
+
+    // Copy the entry of a position to entry, false if the position is not stored.
+    bool probe(std::uint64_t key, tt_entry& entry) const;
+
+    // Store search result of position. Deeper results and exact scores are preferred.
+    void store(std::uint64_t key, int depth, bound type, score_t score, const chess::move& move);
+
+    std::size_t megabytes() const;
+
+    // Used slots per thousand, estimated from the start of the table.
+    int hashfull() const;
+
+private:
+    struct slot
+    {
+        std::atomic<std::uint64_t> check;
+        std::atomic<std::uint64_t> data;
+    };
+
+    static_assert(sizeof(slot) == 16, "transposition table slots should stay compact");
+
+    std::unique_ptr<slot[]> slots;
+    std::size_t count;
+    std::uint64_t mask;
+    std::size_t size_mb;
+};
+
+
+// Moves are stored as from | to << 6 | promote << 12.
+std::uint16_t pack_move(const chess::move& move);
+chess::move unpack_move(std::uint16_t packed);
+
+// Compare moves by their packed representation.
+bool same_move(const chess::move& a, const chess::move& b);
+
+
+}
+
+
+#endif
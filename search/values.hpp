@@ -0,0 +1,23 @@
+#ifndef VALUES_HPP
+#define VALUES_HPP
+
+#include <chess/chess.hpp>
+
+
+namespace search
+{
+
+
+// Material values in centipawns, indexed by piece: pawn, rook, knight, bishop, queen, king.
+constexpr int piece_values[6] = {100, 500, 300, 300, 900, 0};
+
+constexpr int piece_value(chess::piece piece)
+{
+    return piece == chess::piece_none ? 0 : piece_values[piece];
+}
+
+
+}
+
+
+#endif
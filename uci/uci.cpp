@@ -297,6 +297,40 @@ void search_info::move(const chess::move& move, int number)
     push_message(out.str());
 }
 
+void search_info::iteration(int depth, int selective, int multipv, float centipawn, std::optional<int> mate, unsigned long long nodes, int hashfull, const std::vector<chess::move>& best)
+{
+    auto current_time = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed = current_time - search_start;
+    unsigned long long nps = elapsed.count() > 0.0 ? static_cast<unsigned long long>(nodes / elapsed.count()) : 0;
+
+	std::ostringstream out;
+	out << "info depth " << depth << " seldepth " << selective << " multipv " << multipv;
+
+    if(mate)
+    {
+        out << " score mate " << *mate;
+    }
+    else
+    {
+        out << " score cp " << static_cast<int>(centipawn);
+    }
+
+    out << " nodes " << nodes << " nps " << nps << " hashfull " << hashfull;
+    out << " time " << std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+
+    if(!best.empty())
+    {
+        out << " pv";
+
+        for(const chess::move& move: best)
+        {
+            out << ' ' << move.to_lan();
+        }
+    }
+
+    push_message(out.str());
+}
+
 void search_info::message(const std::string& message)
 {
 	push_message("info string " + message);
@@ -326,7 +360,7 @@ static std::string extract_until(std::istream& in, std::string_view until = "")
         result += dummy + ' ';
     }
 
-    if(result.back() == ' ')
+    if(!result.empty() && result.back() == ' ')
     {
         result = result.substr(0, result.size()-1);
     }
@@ -389,7 +423,11 @@ int main(engine& engine)
             stream >> dummy;
 
 			std::string name = extract_until(stream, "value");
-            std::string value = extract_until(stream);
+
+            // The value is the rest of the line as it was sent, paths may contain spaces
+            std::string value;
+            std::getline(stream >> std::ws, value);
+            value.erase(value.find_last_not_of(" \t\r") + 1);
 
 			engine.opt.set(name, value);
 		}
@@ -399,16 +437,22 @@ int main(engine& engine)
         }
         else if(command == "position")
         {
+            std::string token;
             std::string fen;
-            stream >> fen;
+            stream >> token;
 
-            if(fen == "startpos")
+            if(token == "startpos")
             {
                 fen = chess::position::fen_start;
+                stream >> dummy; // moves
             }
             else
             {
-                stream >> fen;
+                // fen has several space separated fields, read until the move list
+                while(stream >> token && token != "moves")
+                {
+                    fen += fen.empty() ? token : " " + token;
+                }
             }
 
             chess::position position = chess::position::from_fen(fen);
@@ -416,8 +460,6 @@ int main(engine& engine)
             std::string lan;
             std::vector<chess::move> moves;
 
-            stream >> dummy;
-
             while(stream >> lan)
             {
                 chess::move move = chess::move::from_lan(lan);
@@ -430,6 +472,9 @@ int main(engine& engine)
         {
             search_limit limit;
 
+            // a search only ponders if this go command says so
+            ponder = false;
+
             while(stream >> command)
             {
                 if(command == "searchmoves")
@@ -507,7 +552,8 @@ int main(engine& engine)
 
             stop = false;
             info = search_info();
-            std::thread(search, std::ref(engine), std::ref(limit), std::ref(info), std::ref(ponder), std::ref(stop)).detach();
+            // limit goes out of scope before the search ends, so the thread gets its own copy
+            std::thread(search, std::ref(engine), limit, std::ref(info), std::ref(ponder), std::ref(stop)).detach();
             // todo: might want to give over ownership of engine to search thread
         }
         else if(command == "stop")
@@ -147,7 +147,7 @@ using option_string = option_value<std::string>;
 class options
 {
 public:
-    // Add option. Arguments forwarded to option constructor.
+    // Add or replace option. Arguments forwarded to option constructor.
     template<class T, class... Ts> //requires std::derived_from<T, option>
     const T& add(const std::string& name, Ts&&... args);
 
@@ -230,6 +230,20 @@ public:
     // Current move being searched.
     void move(const chess::move& current, int number);
 
+    /**
+     * Summary of a finished iteration on one line, sent once for each line with MultiPV.
+     *
+     * @param depth         Search depth
+     * @param selective     Deepest ply reached
+     * @param multipv       Rank of the line, counting from 1
+     * @param centipawn     Score, used if there is no mate
+     * @param mate          Moves to mate, negative if the engine is getting mated
+     * @param nodes         Nodes searched since the start of the search
+     * @param hashfull      Used part of the hash table, per thousand
+     * @param best          Best line
+     */
+    void iteration(int depth, int selective, int multipv, float centipawn, std::optional<int> mate, unsigned long long nodes, int hashfull, const std::vector<chess::move>& best);
+
     // Send info message.
     void message(const std::string& message);
 
@@ -307,10 +321,24 @@ void uci::option_value<T>::insert(std::ostream& out) const
     out << "type string default " << value;
 }
 
+// A string is the whole value, GUIs send and show <empty> for an empty one
+template <>
+inline void uci::option_value<std::string>::set(const std::string& new_value)
+{
+    value = new_value == "<empty>" ? std::string() : new_value;
+}
+
+template <>
+inline void uci::option_value<std::string>::insert(std::ostream& out) const
+{
+    out << "type string default " << (value.empty() ? "<empty>" : value);
+}
+
 template<class T, class... Args> //requires std::derived_from<T, uci::option>
 const T& uci::options::add(const std::string& name, Args&&... args)
 {
-    holder.emplace(key(name), std::make_unique<T>(std::forward<Args>(args)...));
+    // replace existing option, engines may redefine the defaults from uci::engine
+    holder.insert_or_assign(key(name), std::make_shared<T>(std::forward<Args>(args)...));
     return dynamic_cast<T&>(*holder.at(key(name)));
 }
 